@@ -0,0 +1,119 @@
+// Validation and planning tool for the I²C bus-time cost model (pvc/bus.hpp),
+// on a host with a C++17 compiler. For example:
+//
+//   c++ -std=c++17 -O2 -I../../include bus_model.cpp -o bus_model
+//   ./bus_model [trace.csv]
+//
+// Without arguments, prints the modeled wire time of each operation in every
+// bus mode, and the capacity of a bus shared by 1 – 16 default-configured
+// devices that each read voltage, current, and power.
+//
+// With a trace file, compares the model against measured operation timings,
+// such as those exported from a logic analyzer. Each line of the trace has the
+// form (lines beginning with '#' are ignored):
+//
+//   <bus frequency (Hz)>,<operation>,<measured duration (µs)>
+//
+// where <operation> is one of: read_split, read_repeated, read_cached, write.
+// Measured durations should span from START to the next START, so that they
+// include the bus-free time. The exit status is non-zero if any measurement
+// deviates from the model by more than 25%.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+
+#include "pvc/bus.hpp"
+
+static constexpr std::array<std::pair<bus::op, std::string_view>, 4> op_names = {{
+  { bus::op::read_split, "read_split" },
+  { bus::op::read_repeated, "read_repeated" },
+  { bus::op::read_cached, "read_cached" },
+  { bus::op::write, "write" },
+}};
+
+static void print_model() {
+  std::printf("%-14s", "operation");
+  for (const auto &m : bus::modes) {
+    std::printf(" %10.0fkHz", m.freq_hz / 1000.0);
+  }
+  std::printf("\n");
+  for (const auto &[op, name] : op_names) {
+    std::printf("%-14s", name.data());
+    for (const auto &m : bus::modes) {
+      std::printf(" %11.2fµs", bus::cost_us(op, m));
+    }
+    std::printf("\n");
+  }
+
+  std::printf("\ncapacity with default configuration (%u µs conversion period),\n"
+    "3 registers per sample, repeated START:\n\n", ina260::config().conversion_period_us());
+  std::printf("%-8s %-9s %12s %12s %12s %14s\n",
+    "devices", "freq", "utilization", "rate (Hz)", "max (Hz)", "worst age (µs)");
+  for (const std::size_t n : { 1, 2, 4, 8, 16 }) {
+    for (const auto &m : bus::modes) {
+      std::array<bus::plan, 16> plans = {};
+      for (std::size_t i = n; i < plans.size(); ++i) {
+        plans[i].config = ina260::config().type(ina260::config::op_type::shutdown);
+        plans[i].reads = 0;
+      }
+      const auto e = bus::capacity(m.freq_hz, plans);
+      std::printf("%-8zu %-9u %11.1f%% %12.1f %12.1f %14.1f\n",
+        n, m.freq_hz, 100.0 * e.utilization, e.device[0].rate_hz,
+        e.max_rate_hz, e.device[0].worst_us);
+    }
+  }
+}
+
+static int validate(const char *path) {
+  std::FILE *f = std::fopen(path, "r");
+  if (f == nullptr) {
+    std::perror(path);
+    return 2;
+  }
+  int failed = 0, malformed = 0, count = 0;
+  char line[256];
+  std::printf("%-9s %-14s %12s %12s %8s\n", "freq", "operation", "model (µs)", "trace (µs)", "error");
+  while (std::fgets(line, sizeof(line), f) != nullptr) {
+    if (line[0] == '#' || line[0] == '\n') {
+      continue;
+    }
+    unsigned long freq = 0;
+    char name[32] = { 0 };
+    double measured = 0.0;
+    if (std::sscanf(line, "%lu,%31[^,],%lf", &freq, name, &measured) != 3) {
+      std::fprintf(stderr, "malformed trace line: %s", line);
+      ++malformed;
+      continue;
+    }
+    const auto *it = std::find_if(op_names.begin(), op_names.end(),
+      [&](const auto &p) { return p.second == name; });
+    if (it == op_names.end()) {
+      std::fprintf(stderr, "unknown operation: %s\n", name);
+      ++malformed;
+      continue;
+    }
+    const double model = bus::cost_us(it->first, static_cast<std::uint32_t>(freq));
+    const double error = (measured - model) / model;
+    const bool bad = std::fabs(error) > 0.25;
+    std::printf("%-9lu %-14s %12.2f %12.2f %+7.1f%%%s\n",
+      freq, name, model, measured, 100.0 * error, bad ? "  !" : "");
+    failed += bad ? 1 : 0;
+    ++count;
+  }
+  std::fclose(f);
+  std::printf("\n%d of %d measurements within 25%% of the model\n", count - failed, count);
+  return (failed || malformed) ? 1 : 0;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1) {
+    return validate(argv[1]);
+  }
+  print_model();
+  return 0;
+}
@@ -0,0 +1,76 @@
+// Benchmark of the bulk register decoders (pvc/decode.hpp) against the scalar
+// conversion, on a host with a C++17 compiler. For example:
+//
+//   c++ -std=c++17 -O2 -march=native -I../../include decode_bench.cpp -o decode_bench
+//   ./decode_bench [samples]
+//
+// Each kernel is verified against the scalar output before it is timed.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "pvc/decode.hpp"
+
+using ina260::config;
+
+template <typename F>
+static double ns_per_sample(const std::size_t size, F &&f) {
+  constexpr int rounds = 20;
+  f(); // warm up caches
+  const auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; ++r) { f(); }
+  const auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() /
+    (static_cast<double>(rounds) * static_cast<double>(size));
+}
+
+int main(int argc, char *argv[]) {
+  const std::size_t size = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : 1 << 20;
+
+  std::vector<std::uint16_t> raw(size);
+  std::mt19937 rng(0x260);
+  for (auto &r : raw) { r = static_cast<std::uint16_t>(rng()); }
+
+  std::vector<float>        fs(size), fv(size);
+  std::vector<std::int32_t> is(size), iv(size);
+
+#if defined(PVC_DECODE_AVX2)
+  std::printf("kernel: AVX2\n");
+#elif defined(PVC_DECODE_SSE2)
+  std::printf("kernel: SSE2\n");
+#elif defined(PVC_DECODE_NEON)
+  std::printf("kernel: NEON\n");
+#else
+  std::printf("kernel: scalar\n");
+#endif
+  std::printf("%-8s %-6s %10s %10s %8s\n", "channel", "output", "scalar", "bulk", "speedup");
+
+  int failed = 0;
+  for (const auto type : { config::op_type::voltage, config::op_type::current }) {
+    decode::scalar::to_float(type, raw.data(), fs.data(), size);
+    decode::to_float(type, raw.data(), fv.data(), size);
+    decode::scalar::to_fixed(type, raw.data(), is.data(), size);
+    decode::to_fixed(type, raw.data(), iv.data(), size);
+    if (std::memcmp(fs.data(), fv.data(), size * sizeof(float)) ||
+        std::memcmp(is.data(), iv.data(), size * sizeof(std::int32_t))) {
+      std::printf("%-8s mismatch between scalar and bulk output\n",
+        config::value_of_key(type).data());
+      ++failed;
+      continue;
+    }
+    const double f0 = ns_per_sample(size, [&] { decode::scalar::to_float(type, raw.data(), fs.data(), size); });
+    const double f1 = ns_per_sample(size, [&] { decode::to_float(type, raw.data(), fv.data(), size); });
+    const double i0 = ns_per_sample(size, [&] { decode::scalar::to_fixed(type, raw.data(), is.data(), size); });
+    const double i1 = ns_per_sample(size, [&] { decode::to_fixed(type, raw.data(), iv.data(), size); });
+    std::printf("%-8s %-6s %8.3fns %8.3fns %7.2fx\n",
+      config::value_of_key(type).data(), "float", f0, f1, f0 / f1);
+    std::printf("%-8s %-6s %8.3fns %8.3fns %7.2fx\n",
+      config::value_of_key(type).data(), "fixed", i0, i1, i0 / i1);
+  }
+  return failed;
+}
@@ -1,6 +1,7 @@
 #include <Arduino.h>
 #include "pvc/i2c_arduino.hpp"
 #include "pvc.hpp"
+#include "pvc/startup.hpp"
 
 // Declare a pvc driver instance that uses the Arduino adapter.
 // Bus 0 is the same as the default Wire object (e.g., use i2c(1) for Wire1).
@@ -33,16 +34,20 @@ struct measure { bool valid; float value; };
 void setup() {
   Serial.begin(115200);
 
-  // Initialize the pvc driver and Arduino adapter.
-  while (!sensor.init() || !sensor.ready())
+  // Initialize the pvc driver and Arduino adapter, and commit our configuration
+  // settings to the sensor. Registers that already hold these settings (e.g.,
+  // if only the MCU was restarted) are verified instead of rewritten.
+  //
+  // The image also holds the MASK/ENABLE and ALERT_LIMIT registers, which
+  // configure how the ALERT pin functions, and the threshold values for that
+  // function, respectively. Any number of sensors can be started in one pass.
+  startup::report<1> report;
+  while (!startup::warm_start(std::array<decltype(sensor) *, 1>{ &sensor },
+           startup::image{ config }, report))
     { delay(200); }
 
-  // Commit our configuration settings to the sensor.
-  while (!sensor.write_config(config))
-    { delay(200); }
-
-  // You can use write_masken() and write_alimit() to configure how the ALERT
-  // pin functions, and the threshold values for that function, respectively.
+  Serial.printf("sensor ready in %uµs (%u register writes)\n",
+    unsigned(report.total_us), unsigned(report.writes()));
 }
 
 void loop() {
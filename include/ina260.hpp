@@ -2,9 +2,11 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <string>
 #include <string_view>
 #include <array>
-#include <string_view>
+#include <type_traits>
+#include <utility>
 
 #include "pvc/internal/util.hpp"
 
@@ -80,6 +82,25 @@ namespace ina260 {
     return default_value;
   }
 
+  // Bit field of a 16-bit register image with the given offset and width,
+  // whose value is represented by type T (an integer, bool, or enum class).
+  template <unsigned Offset, unsigned Width, typename T>
+  struct field {
+    static_assert(Offset + Width <= 16, "field exceeds register width");
+
+    static constexpr std::uint16_t mask =
+      static_cast<std::uint16_t>(((1U << Width) - 1U) << Offset);
+
+    static constexpr T get(const std::uint16_t u16) {
+      return static_cast<T>((u16 & mask) >> Offset);
+    }
+
+    static constexpr std::uint16_t set(const std::uint16_t u16, const T value) {
+      return static_cast<std::uint16_t>((u16 & ~mask) |
+        ((static_cast<unsigned>(value) << Offset) & mask));
+    }
+  };
+
   // Format of the CONFIGURATION register (00h)
   struct config {
 
@@ -114,12 +135,16 @@ namespace ina260 {
       );
     }
 
+    static constexpr pairs_type<op_type, std::string_view, 3> const units_mapping = {{
+      {op_type::current, std::string_view("A")},
+      {op_type::voltage, std::string_view("V")},
+      {op_type::power, std::string_view("W")}
+    }};
+
+    // Prefix of the sensor's native units (e.g., mA).
+    static constexpr std::string_view const units_prefix = "m";
+
     static constexpr const std::string_view to_base_units(op_type value) {
-      static constexpr pairs_type<op_type, std::string_view, 3> const units_mapping = {{
-        {op_type::current, "A"},
-        {op_type::voltage, "V"},
-        {op_type::power, "W"}
-      }};
       return ina260::value_of_key(
         value, units_mapping, std::string_view("unknown")
       );
@@ -128,11 +153,10 @@ namespace ina260 {
     // Return a string representation of the default measurement units.
     // This returns the same units as to_base_units,
     // but with the sensor's native units prefix.
-    static constexpr const std::string to_units(op_type value) {
-      static constexpr std::string_view const &prefix = "m";
+    static const std::string to_units(op_type value) {
       auto const &units = to_base_units(value);
       if (units == "unknown") { return std::string(units); }
-      return std::string(prefix) + std::string(units);
+      return std::string(units_prefix) + std::string(units);
     }
 
     template <op_type enabled = op_type::power>
@@ -246,23 +270,84 @@ namespace ina260 {
       );
     }
 
-    union alignas(std::uint16_t) {
-      std::uint16_t u16;
-      #pragma pack(push, 1)
-      struct {
-        op_type       type : 2; //  0 —  1
-        op_mode       mode : 1; //  2
-        adc_time     ctime : 3; //  3 —  5
-        adc_time     vtime : 3; //  6 —  8
-        adc_count    count : 3; //  9 — 11
-        std::uint8_t  resv : 3; // 12 — 14
-        std::uint8_t reset : 1; // 15
-      };
-      #pragma pack(pop)
-    };
+    // Duration of a single ADC conversion (µs) for each adc_time.
+    static constexpr pairs_type<adc_time, std::uint32_t, 8> const adc_time_us_mapping = {{
+      {adc_time::us140, 140},
+      {adc_time::us204, 204},
+      {adc_time::us332, 332},
+      {adc_time::us588, 588},
+      {adc_time::ms1p1, 1100},
+      {adc_time::ms2p116, 2116},
+      {adc_time::ms4p156, 4156},
+      {adc_time::ms8p244, 8244}
+    }};
+
+    // Number of ADC conversions averaged for each adc_count.
+    static constexpr pairs_type<adc_count, std::uint32_t, 8> const adc_count_n_mapping = {{
+      {adc_count::n1, 1},
+      {adc_count::n4, 4},
+      {adc_count::n16, 16},
+      {adc_count::n64, 64},
+      {adc_count::n128, 128},
+      {adc_count::n256, 256},
+      {adc_count::n512, 512},
+      {adc_count::n1024, 1024}
+    }};
+
+    // Register image in native byte order. Fields are accessed with the
+    // constexpr accessors below, which have well-defined bit positions
+    // (unlike bitfields, whose ordering is implementation-defined).
+    std::uint16_t u16;
+
+    using type_field  = field< 0, 2, op_type>;   //  0 —  1
+    using mode_field  = field< 2, 1, op_mode>;   //  2
+    using ctime_field = field< 3, 3, adc_time>;  //  3 —  5
+    using vtime_field = field< 6, 3, adc_time>;  //  6 —  8
+    using count_field = field< 9, 3, adc_count>; //  9 — 11
+    using reset_field = field<15, 1, bool>;      // 15
+
+    constexpr op_type type() const { return type_field::get(u16); }
+    constexpr config &type(const op_type value) {
+      u16 = type_field::set(u16, value);
+      return *this;
+    }
+    constexpr op_mode mode() const { return mode_field::get(u16); }
+    constexpr config &mode(const op_mode value) {
+      u16 = mode_field::set(u16, value);
+      return *this;
+    }
+    constexpr adc_time ctime() const { return ctime_field::get(u16); }
+    constexpr config &ctime(const adc_time value) {
+      u16 = ctime_field::set(u16, value);
+      return *this;
+    }
+    constexpr adc_time vtime() const { return vtime_field::get(u16); }
+    constexpr config &vtime(const adc_time value) {
+      u16 = vtime_field::set(u16, value);
+      return *this;
+    }
+    constexpr adc_count count() const { return count_field::get(u16); }
+    constexpr config &count(const adc_count value) {
+      u16 = count_field::set(u16, value);
+      return *this;
+    }
+    constexpr bool reset() const { return reset_field::get(u16); }
+    constexpr config &reset(const bool value) {
+      u16 = reset_field::set(u16, value);
+      return *this;
+    }
 
     static constexpr std::uint16_t reserved_mask = 0x7000;
 
+    // Bits that read back as written (excludes the self-clearing reset bit).
+    static constexpr std::uint16_t setting_mask =
+      static_cast<std::uint16_t>(~(reserved_mask | reset_field::mask));
+
+    // Return true if the settings of both registers are equal.
+    constexpr bool same_settings(const config &other) const {
+      return ((u16 ^ other.u16) & setting_mask) == 0;
+    }
+
     constexpr config(
       const std::uint16_t value,
       const std::uint16_t mask = ~reserved_mask)
@@ -274,42 +359,125 @@ namespace ina260 {
       const adc_time  vtime = adc_time::ms1p1,
       const adc_count count = adc_count::n1,
       const bool      reset = false)
-      : type(type),
-        mode(mode),
-        ctime(ctime),
-        vtime(vtime),
-        count(count),
-        resv(0),
-        reset(reset) {}
+      : u16(type_field::set(0, type) |
+            mode_field::set(0, mode) |
+            ctime_field::set(0, ctime) |
+            vtime_field::set(0, vtime) |
+            count_field::set(0, count) |
+            reset_field::set(0, reset)) {}
+
+    // Return the time (µs) between updates of the measurement registers, i.e.,
+    // the averaged conversion time of every enabled measurement, or 0 if the
+    // device is shut down.
+    constexpr std::uint32_t conversion_period_us() const {
+      constexpr std::uint32_t none = 0;
+      std::uint32_t us = 0;
+      if (is_enabled<op_type::current>(type())) {
+        us += ina260::value_of_key(ctime(), adc_time_us_mapping, none);
+      }
+      if (is_enabled<op_type::voltage>(type())) {
+        us += ina260::value_of_key(vtime(), adc_time_us_mapping, none);
+      }
+      return us * ina260::value_of_key(count(), adc_count_n_mapping, none);
+    }
 
-    virtual ~config() = default;
+    constexpr bool operator==(const config &other) const { return u16 == other.u16; }
+    constexpr bool operator!=(const config &other) const { return u16 != other.u16; }
 
   }; // struct config
 
+  static_assert(sizeof(config) == sizeof(std::uint16_t) &&
+    std::is_trivially_copyable_v<config>, "config must be a 2-byte value type");
+
   // Format of the MASK/ENABLE register (06h)
   struct masken {
-    union alignas(std::uint16_t) {
-      std::uint16_t u16;
-      #pragma pack(push, 1)
-      struct {
-        std::uint8_t  alert_latch_enable : 1; //  0
-        std::uint8_t      alert_polarity : 1; //  1
-        std::uint8_t       math_overflow : 1; //  2
-        std::uint8_t    conversion_ready : 1; //  3
-        std::uint8_t alert_function_flag : 1; //  4
-        std::uint8_t                resv : 5; //  5 —  9
-        std::uint8_t    alert_conversion : 1; // 10
-        std::uint8_t    alert_over_power : 1; // 11
-        std::uint8_t alert_under_voltage : 1; // 12
-        std::uint8_t  alert_over_voltage : 1; // 13
-        std::uint8_t alert_under_current : 1; // 14
-        std::uint8_t  alert_over_current : 1; // 15
-      };
-      #pragma pack(pop)
-    };
+    std::uint16_t u16;
+
+    using alert_latch_enable_field  = field< 0, 1, bool>; //  0
+    using alert_polarity_field      = field< 1, 1, bool>; //  1
+    using math_overflow_field       = field< 2, 1, bool>; //  2
+    using conversion_ready_field    = field< 3, 1, bool>; //  3
+    using alert_function_flag_field = field< 4, 1, bool>; //  4
+    using alert_conversion_field    = field<10, 1, bool>; // 10
+    using alert_over_power_field    = field<11, 1, bool>; // 11
+    using alert_under_voltage_field = field<12, 1, bool>; // 12
+    using alert_over_voltage_field  = field<13, 1, bool>; // 13
+    using alert_under_current_field = field<14, 1, bool>; // 14
+    using alert_over_current_field  = field<15, 1, bool>; // 15
+
+    constexpr bool alert_latch_enable() const { return alert_latch_enable_field::get(u16); }
+    constexpr masken &alert_latch_enable(const bool value) {
+      u16 = alert_latch_enable_field::set(u16, value);
+      return *this;
+    }
+    constexpr bool alert_polarity() const { return alert_polarity_field::get(u16); }
+    constexpr masken &alert_polarity(const bool value) {
+      u16 = alert_polarity_field::set(u16, value);
+      return *this;
+    }
+    constexpr bool math_overflow() const { return math_overflow_field::get(u16); }
+    constexpr masken &math_overflow(const bool value) {
+      u16 = math_overflow_field::set(u16, value);
+      return *this;
+    }
+    constexpr bool conversion_ready() const { return conversion_ready_field::get(u16); }
+    constexpr masken &conversion_ready(const bool value) {
+      u16 = conversion_ready_field::set(u16, value);
+      return *this;
+    }
+    constexpr bool alert_function_flag() const { return alert_function_flag_field::get(u16); }
+    constexpr masken &alert_function_flag(const bool value) {
+      u16 = alert_function_flag_field::set(u16, value);
+      return *this;
+    }
+    constexpr bool alert_conversion() const { return alert_conversion_field::get(u16); }
+    constexpr masken &alert_conversion(const bool value) {
+      u16 = alert_conversion_field::set(u16, value);
+      return *this;
+    }
+    constexpr bool alert_over_power() const { return alert_over_power_field::get(u16); }
+    constexpr masken &alert_over_power(const bool value) {
+      u16 = alert_over_power_field::set(u16, value);
+      return *this;
+    }
+    constexpr bool alert_under_voltage() const { return alert_under_voltage_field::get(u16); }
+    constexpr masken &alert_under_voltage(const bool value) {
+      u16 = alert_under_voltage_field::set(u16, value);
+      return *this;
+    }
+    constexpr bool alert_over_voltage() const { return alert_over_voltage_field::get(u16); }
+    constexpr masken &alert_over_voltage(const bool value) {
+      u16 = alert_over_voltage_field::set(u16, value);
+      return *this;
+    }
+    constexpr bool alert_under_current() const { return alert_under_current_field::get(u16); }
+    constexpr masken &alert_under_current(const bool value) {
+      u16 = alert_under_current_field::set(u16, value);
+      return *this;
+    }
+    constexpr bool alert_over_current() const { return alert_over_current_field::get(u16); }
+    constexpr masken &alert_over_current(const bool value) {
+      u16 = alert_over_current_field::set(u16, value);
+      return *this;
+    }
 
     static constexpr std::uint16_t reserved_mask = 0x03E0;
 
+    // Bits that only report device status, and are ignored when written.
+    static constexpr std::uint16_t status_mask = 0x001C;
+
+    // Bits that select the ALERT function (only one should be set at a time).
+    static constexpr std::uint16_t function_mask = 0xFC00;
+
+    // Bits that read back as written.
+    static constexpr std::uint16_t setting_mask =
+      static_cast<std::uint16_t>(~(reserved_mask | status_mask));
+
+    // Return true if the settings of both registers are equal.
+    constexpr bool same_settings(const masken &other) const {
+      return ((u16 ^ other.u16) & setting_mask) == 0;
+    }
+
     constexpr masken(
       const std::uint16_t value,
       const std::uint16_t mask = ~reserved_mask)
@@ -326,59 +494,77 @@ namespace ina260 {
       const bool  alert_over_voltage = false,
       const bool alert_under_current = false,
       const bool  alert_over_current = false)
-      : alert_latch_enable(alert_latch_enable),
-        alert_polarity(alert_polarity),
-        math_overflow(math_overflow),
-        conversion_ready(conversion_ready),
-        alert_function_flag(alert_function_flag),
-        resv(0),
-        alert_conversion(alert_conversion),
-        alert_over_power(alert_over_power),
-        alert_under_voltage(alert_under_voltage),
-        alert_over_voltage(alert_over_voltage),
-        alert_under_current(alert_under_current),
-        alert_over_current(alert_over_current) {}
-
-    virtual ~masken() = default;
+      : u16(alert_latch_enable_field::set(0, alert_latch_enable) |
+            alert_polarity_field::set(0, alert_polarity) |
+            math_overflow_field::set(0, math_overflow) |
+            conversion_ready_field::set(0, conversion_ready) |
+            alert_function_flag_field::set(0, alert_function_flag) |
+            alert_conversion_field::set(0, alert_conversion) |
+            alert_over_power_field::set(0, alert_over_power) |
+            alert_under_voltage_field::set(0, alert_under_voltage) |
+            alert_over_voltage_field::set(0, alert_over_voltage) |
+            alert_under_current_field::set(0, alert_under_current) |
+            alert_over_current_field::set(0, alert_over_current)) {}
+
+    constexpr bool operator==(const masken &other) const { return u16 == other.u16; }
+    constexpr bool operator!=(const masken &other) const { return u16 != other.u16; }
 
   }; // struct masken
 
+  static_assert(sizeof(masken) == sizeof(std::uint16_t) &&
+    std::is_trivially_copyable_v<masken>, "masken must be a 2-byte value type");
+
   // Format of the ALERT_LIMIT register (07h)
   struct alimit {
-    union alignas(std::uint16_t) {
-      std::uint16_t u16;
-      #pragma pack(push, 1)
-      struct {
-        std::uint16_t limit; //  0 — 15
-      };
-      #pragma pack(pop)
-    };
+    std::uint16_t u16;
+
+    constexpr std::uint16_t limit() const { return u16; } //  0 — 15
+    constexpr alimit &limit(const std::uint16_t value) {
+      u16 = value;
+      return *this;
+    }
 
     static constexpr std::uint16_t reserved_mask = 0x0;
 
+    // Bits that read back as written.
+    static constexpr std::uint16_t setting_mask =
+      static_cast<std::uint16_t>(~reserved_mask);
+
+    // Return true if the settings of both registers are equal.
+    constexpr bool same_settings(const alimit &other) const {
+      return ((u16 ^ other.u16) & setting_mask) == 0;
+    }
+
     constexpr alimit(
-      const std::uint16_t value,
+      const std::uint16_t value = 0x0000,
       const std::uint16_t mask = ~reserved_mask)
       : u16(value & mask) {}
-    constexpr alimit(
-      const std::uint16_t limit = 0x0000)
-      : limit(limit) {}
 
-    virtual ~alimit() = default;
+    constexpr bool operator==(const alimit &other) const { return u16 == other.u16; }
+    constexpr bool operator!=(const alimit &other) const { return u16 != other.u16; }
 
   }; // struct alimit
 
+  static_assert(sizeof(alimit) == sizeof(std::uint16_t) &&
+    std::is_trivially_copyable_v<alimit>, "alimit must be a 2-byte value type");
+
   // Format of the DEVICE_ID register (FFh)
   struct device {
-    union alignas(std::uint16_t) {
-      std::uint16_t u16;
-      #pragma pack(push, 1)
-      struct {
-        std::uint8_t  revision :  4;
-        std::uint16_t deviceid : 12;
-      };
-      #pragma pack(pop)
-    };
+    std::uint16_t u16;
+
+    using revision_field = field<0,  4, std::uint8_t>;  //  0 —  3
+    using deviceid_field = field<4, 12, std::uint16_t>; //  4 — 15
+
+    constexpr std::uint8_t revision() const { return revision_field::get(u16); }
+    constexpr device &revision(const std::uint8_t value) {
+      u16 = revision_field::set(u16, value);
+      return *this;
+    }
+    constexpr std::uint16_t deviceid() const { return deviceid_field::get(u16); }
+    constexpr device &deviceid(const std::uint16_t value) {
+      u16 = deviceid_field::set(u16, value);
+      return *this;
+    }
 
     static constexpr std::uint16_t reserved_mask = 0x0;
 
@@ -389,10 +575,11 @@ namespace ina260 {
     constexpr device(
       const std::uint8_t revision = default_revision,
       const std::uint16_t deviceid = default_deviceid)
-      : revision(revision),
-        deviceid(deviceid) {}
+      : u16(revision_field::set(0, revision) |
+            deviceid_field::set(0, deviceid)) {}
 
-    virtual ~device() = default;
+    constexpr bool operator==(const device &other) const { return u16 == other.u16; }
+    constexpr bool operator!=(const device &other) const { return u16 != other.u16; }
 
     constexpr bool operator==(std::uint8_t (&p)[sizeof(u16)]) const {
       for (std::size_t i = 0; i < sizeof(u16); ++i) {
@@ -405,6 +592,38 @@ namespace ina260 {
 
   }; // struct device
 
+  static_assert(sizeof(device) == sizeof(std::uint16_t) &&
+    std::is_trivially_copyable_v<device>, "device must be a 2-byte value type");
+
+  // Raw contents of the measurement registers, read back-to-back. The three
+  // registers are not guaranteed to be from the same conversion, since the
+  // device may complete a conversion between any two of the reads.
+  //
+  // Register words are kept exactly as read from the device, so that a sample
+  // remains 6 bytes and can be buffered or compared without any conversion.
+  // Multiply by the corresponding lsb_* constant to obtain physical units.
+  struct sample {
+    std::uint16_t voltage; // BUS_VOLTAGE register (02h)
+    std::uint16_t current; // CURRENT register (01h), two's complement
+    std::uint16_t power;   // POWER register (03h)
+
+    // Return the raw reading of the given measurement, sign-extended where
+    // applicable. The shutdown type has no measurement and always returns 0.
+    constexpr std::int32_t value(const config::op_type type) const {
+      switch (type) {
+        case config::op_type::current:
+          return static_cast<std::int16_t>(current);
+        case config::op_type::voltage:
+          return voltage;
+        case config::op_type::power:
+          return power;
+        default:
+          return 0;
+      }
+    }
+
+  }; // struct sample
+
   // Return the given I²C device address, masked to standard 7-bit addressing.
   constexpr auto dev_addr_id(std::uint8_t addr) {
     return addr & 0x7F;
@@ -1,17 +1,35 @@
 #pragma once
 
 #include <cstddef>
+#include <cstring>
 #include <type_traits>
 #include <utility>
 
 #ifdef ARDUINO
 #include "pvc/i2c_arduino.hpp"
 using I2C = arduino::I2C; // Use the Arduino I²C implementation
+#elif defined(__linux__) && !defined(ESP_PLATFORM)
+#include "pvc/i2c_linux.hpp"
+using I2C = i2cdev::I2C; // Use the Linux i2c-dev I²C implementation
 #else
 #include "pvc/i2c_espidf.hpp"
 using I2C = espidf::I2C; // Use the ESP-IDF I²C implementation
 #endif
 
+// Coroutine methods (async_*) are only available if PVC_ASYNC is defined as 1,
+// which requires C++20 coroutines and a standard library with thread support
+// (std::mutex, etc.), unlike the rest of the library.
+#if !defined(PVC_ASYNC)
+#define PVC_ASYNC 0
+#endif
+
+#if PVC_ASYNC
+#if !defined(__cpp_impl_coroutine) || !__has_include(<coroutine>)
+#error "PVC_ASYNC requires C++20 coroutine support"
+#endif
+#include "pvc/async.hpp"
+#endif
+
 #include "ina260.hpp"
 
 template <typename I = I2C>
@@ -178,6 +196,69 @@ public:
     return true;
   }
 
+  // Read the raw voltage, current, and power registers into the given sample.
+  // Returns false if any of the three registers could not be read, in which
+  // case the content of the sample is unspecified.
+  //
+  // The registers are read back-to-back by independent transactions, so they
+  // are not guaranteed to be from the same conversion.
+  bool snapshot(ina260::sample &sample) {
+    return read_register(ina260::reg::voltage, sample.voltage) &&
+      read_register(ina260::reg::current, sample.current) &&
+      read_register(ina260::reg::power, sample.power);
+  }
+
+  // Read the raw content of the measurement register for the given type,
+  // sign-extended where applicable (see ina260::sample::value).
+  bool measure(const ina260::config::op_type type, std::int32_t &value) {
+    ina260::sample sample = {};
+    bool ok = false;
+    switch (type) {
+      case ina260::config::op_type::current:
+        ok = read_register(ina260::reg::current, sample.current);
+        break;
+      case ina260::config::op_type::voltage:
+        ok = read_register(ina260::reg::voltage, sample.voltage);
+        break;
+      case ina260::config::op_type::power:
+        ok = read_register(ina260::reg::power, sample.power);
+        break;
+      default:
+        break;
+    }
+    if (ok) {
+      value = sample.value(type);
+    }
+    return ok;
+  }
+
+#if PVC_ASYNC
+  // Asynchronous snapshot(), for adapters that implement proto::AsyncI2C.
+  // Must be awaited from a coroutine running on an async::executor, which is
+  // free to run other coroutines while the I²C transactions are in flight.
+  async::task<bool> async_snapshot(ina260::sample &sample) {
+    co_return co_await async_read_register(ina260::reg::voltage, sample.voltage) &&
+      co_await async_read_register(ina260::reg::current, sample.current) &&
+      co_await async_read_register(ina260::reg::power, sample.power);
+  }
+
+  // Asynchronous write_config(), for adapters that implement proto::AsyncI2C.
+  async::task<bool> async_write_config(const ina260::config config) {
+    static_assert(std::is_base_of_v<proto::AsyncI2C, interface>,
+      "interface must implement proto::AsyncI2C");
+    std::uint8_t u[sizeof(config.u16)] = { 0 };
+    std::memcpy(u, &config.u16, sizeof(u));
+    auto nw = co_await async::write(_i2c,
+      static_cast<std::uint8_t>(ina260::reg::configuration), u, sizeof(u)
+    );
+    if (nw != sizeof(config.u16)) {
+      co_return false;
+    }
+    _config.u16 = config.u16;
+    co_return true;
+  }
+#endif
+
 private:
   interface     *_i2c;
   std::uint8_t   _addr;
@@ -187,4 +268,29 @@ private:
   ina260::masken _masken;
   ina260::alimit _alimit;
 
+  // Read the raw (native byte order) content of the given register.
+  bool read_register(const ina260::reg reg, std::uint16_t &u16) {
+    std::uint8_t u[sizeof(u16)] = { 0 };
+    auto nr = _i2c->read(static_cast<std::uint8_t>(reg), u, sizeof(u));
+    if (nr != sizeof(u)) {
+      return false;
+    }
+    std::memcpy(&u16, u, sizeof(u));
+    return true;
+  }
+
+#if PVC_ASYNC
+  async::task<bool> async_read_register(const ina260::reg reg, std::uint16_t &u16) {
+    static_assert(std::is_base_of_v<proto::AsyncI2C, interface>,
+      "interface must implement proto::AsyncI2C");
+    std::uint8_t u[sizeof(u16)] = { 0 };
+    auto nr = co_await async::read(_i2c, static_cast<std::uint8_t>(reg), u, sizeof(u));
+    if (nr != sizeof(u)) {
+      co_return false;
+    }
+    std::memcpy(&u16, u, sizeof(u));
+    co_return true;
+  }
+#endif
+
 }; // class pvc
@@ -0,0 +1,385 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "ina260.hpp"
+
+// Parallel acquisition from sensors on multiple independent I²C buses.
+//
+// Each bus is driven by its own worker thread, which samples every sensor on
+// that bus in turn, stamps each sample from a common monotonic clock, and
+// passes it to the consumer through a lock-free single-producer/single-consumer
+// queue. Workers share no state with each other, so total throughput scales
+// with the number of buses. The consumer merges the streams of all buses into
+// frames of a fixed time window, each holding the most recent sample of every
+// rail (sensor) within that window.
+//
+// The driver type P must provide bool snapshot(ina260::sample &), such as
+// pvc<I>. All sensors of one bus must be accessed by only one engine, since the
+// driver of each bus is used from its worker thread without locking.
+namespace acquire {
+
+using clock = std::chrono::steady_clock;
+
+// Return the current time of the common monotonic clock (ns).
+inline std::uint64_t now_ns() {
+  return static_cast<std::uint64_t>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(
+      clock::now().time_since_epoch()).count());
+}
+
+// A sample of one rail, stamped at the midpoint of its I²C transactions.
+struct stamped {
+  std::uint64_t  time_ns;
+  std::uint16_t  rail;
+  bool           valid;  // false if any register could not be read
+  ina260::sample sample;
+};
+
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+// N must be a power of two.
+template <typename T, std::size_t N>
+class spsc {
+public:
+  static_assert(N > 1 && (N & (N - 1)) == 0, "queue depth must be a power of two");
+
+  // Enqueue an element. Returns false (and drops it) if the queue is full.
+  bool push(const T &value) {
+    const auto tail = _tail.load(std::memory_order_relaxed);
+    if (tail - _head.load(std::memory_order_acquire) == N) {
+      return false;
+    }
+    _slot[tail & (N - 1)] = value;
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Dequeue the oldest element. Returns false if the queue is empty.
+  bool pop(T &value) {
+    const auto head = _head.load(std::memory_order_relaxed);
+    if (head == _tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+    value = _slot[head & (N - 1)];
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  alignas(64) std::atomic<std::size_t> _head{0};
+  alignas(64) std::atomic<std::size_t> _tail{0};
+  alignas(64) std::array<T, N>         _slot{};
+};
+
+// Counters of a single bus worker.
+struct bus_stats {
+  std::uint64_t samples; // samples enqueued
+  std::uint64_t errors;  // samples with a failed I²C transaction
+  std::uint64_t dropped; // samples discarded because the consumer fell behind
+  double        rate_hz; // samples per second between start() and stop()
+};
+
+// Alignment of frames across all rails.
+struct skew_stats {
+  std::uint64_t frames;  // frames emitted
+  std::uint64_t late;    // samples discarded because their frame was emitted
+  std::uint64_t max_ns;  // largest skew of any frame
+  double        mean_ns; // mean skew of all frames with two or more samples
+};
+
+// Samples of every rail within one time window.
+struct frame {
+  std::uint64_t        index;   // window number since start()
+  std::uint64_t        time_ns; // start of the window
+  std::uint64_t        skew_ns; // spread of sample times within the window
+  std::size_t          present; // rails with a sample in this window
+  std::vector<stamped> rail;    // indexed by rail; time_ns == 0 if absent
+};
+
+template <typename P, std::size_t Depth = 4096>
+class engine {
+public:
+  using driver = P;
+
+  // Construct an engine that merges samples into frames of the given window,
+  // which must be positive (if assertions are disabled, 0 is taken as 1 ns).
+  explicit engine(const std::uint64_t window_ns)
+    : _window(window_ns > 0 ? window_ns : 1) {
+    assert(window_ns > 0 && "frame window must be positive");
+  }
+
+  ~engine() { stop(); }
+
+  engine(const engine &) = delete;
+  engine &operator=(const engine &) = delete;
+
+  // Add a bus with the given sensors, which are assigned consecutive rail
+  // numbers following those of any previously added bus. Its worker thread is
+  // pinned to the given CPU (Linux only; -1 for any CPU), and samples every
+  // sensor once per period (0 for as fast as the bus allows).
+  //
+  // Must be called while stopped. The index of the bus (see stats()) is the
+  // number of buses() before the call. Returns false, and adds no bus, if the
+  // list of sensors is empty, since such a bus would never complete a frame.
+  bool add_bus(const std::vector<driver *> &sensors,
+    const int cpu = -1, const std::uint64_t period_ns = 0) {
+    if (sensors.empty()) {
+      return false;
+    }
+    const auto first = static_cast<std::uint16_t>(_rails);
+    _bus.emplace_back(new worker(sensors, first, cpu, period_ns));
+    _rails += sensors.size();
+    return true;
+  }
+
+  std::size_t buses() const { return _bus.size(); }
+  std::size_t rails() const { return _rails; }
+
+  // Return a frame with storage for every rail, to be reused with poll().
+  frame make_frame() const {
+    return frame{ 0, 0, 0, 0, std::vector<stamped>(_rails, stamped{}) };
+  }
+
+  // Start sampling on every bus, discarding any samples and counters of a
+  // previous run. If already running, sampling is stopped and restarted.
+  void start() {
+    stop();
+    for (auto &b : _bus) {
+      b->reset();
+    }
+    _origin = now_ns();
+    _stopped = 0;
+    _current = 0;
+    _pending = make_frame();
+    _skew = {};
+    _skew_sum = 0.0;
+    _skew_n = 0;
+    for (auto &b : _bus) {
+      b->start(_origin);
+    }
+  }
+
+  // Stop sampling, and wait for every worker thread to finish.
+  void stop() {
+    for (auto &b : _bus) {
+      b->stop();
+    }
+    if (_stopped == 0) {
+      _stopped = now_ns();
+    }
+  }
+
+  // Merge queued samples of all buses, and copy the oldest complete frame into
+  // the given frame (see make_frame()). A frame is complete once every bus has
+  // delivered a sample stamped after the end of its window. Returns false if
+  // no frame is complete yet. Never blocks, and never allocates if f was
+  // obtained from make_frame().
+  bool poll(frame &f) {
+    bool complete = !_bus.empty();
+    for (auto &b : _bus) {
+      // Consume this bus's samples until one is beyond the current window.
+      stamped s;
+      while (!b->held && b->queue.pop(s)) {
+        const std::uint64_t w = window_of(s);
+        if (w < _current) {
+          ++_skew.late;
+        } else if (w == _current) {
+          accept(s);
+        } else {
+          b->next = s;
+          b->held = true;
+        }
+      }
+      complete = complete && b->held;
+    }
+    if (!complete) {
+      return false;
+    }
+    // Emit the current window, then begin the next window that has a sample.
+    std::uint64_t next = UINT64_MAX;
+    for (auto &b : _bus) {
+      next = window_of(b->next) < next ? window_of(b->next) : next;
+    }
+    emit(f);
+    _current = next;
+    for (auto &b : _bus) {
+      if (window_of(b->next) == _current) {
+        accept(b->next);
+        b->held = false;
+      }
+    }
+    return true;
+  }
+
+  bus_stats stats(const std::size_t bus) const {
+    const auto &b = *_bus[bus];
+    const std::uint64_t end = _stopped != 0 ? _stopped : now_ns();
+    const double elapsed = static_cast<double>(end - _origin) * 1.0e-9;
+    const auto samples = b.samples.load(std::memory_order_relaxed);
+    return bus_stats{
+      samples,
+      b.errors.load(std::memory_order_relaxed),
+      b.dropped.load(std::memory_order_relaxed),
+      elapsed > 0.0 ? static_cast<double>(samples) / elapsed : 0.0,
+    };
+  }
+
+  skew_stats skew() const { return _skew; }
+
+private:
+  struct worker {
+    std::vector<driver *>  sensor;
+    const std::uint16_t    first;
+    const int              cpu;
+    const std::uint64_t    period;
+    spsc<stamped, Depth>   queue;
+    std::thread            thread;
+    std::atomic<bool>      run{false};
+
+    // Written only by the worker thread.
+    std::atomic<std::uint64_t> samples{0};
+    std::atomic<std::uint64_t> errors{0};
+    std::atomic<std::uint64_t> dropped{0};
+
+    // Accessed only by the consumer thread.
+    stamped next = {};
+    bool    held = false;
+
+    worker(const std::vector<driver *> &sensors, const std::uint16_t first_rail,
+      const int cpu_id, const std::uint64_t period_ns)
+      : sensor(sensors), first(first_rail), cpu(cpu_id), period(period_ns) {}
+
+    void start(const std::uint64_t origin) {
+      run.store(true, std::memory_order_relaxed);
+      thread = std::thread([this, origin] { loop(origin); });
+    }
+
+    void stop() {
+      run.store(false, std::memory_order_relaxed);
+      if (thread.joinable()) {
+        thread.join();
+      }
+    }
+
+    // Discard queued samples and counters. The thread must not be running.
+    void reset() {
+      stamped s;
+      while (queue.pop(s)) {}
+      samples.store(0, std::memory_order_relaxed);
+      errors.store(0, std::memory_order_relaxed);
+      dropped.store(0, std::memory_order_relaxed);
+      held = false;
+    }
+
+    static void bump(std::atomic<std::uint64_t> &counter) {
+      // Single writer, so a plain load/store avoids a locked read-modify-write.
+      counter.store(counter.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+    }
+
+    void loop(std::uint64_t deadline) {
+#if defined(__linux__)
+      // Pin before the first sample, so that no sample is taken elsewhere.
+      if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        (void)pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+      }
+#endif
+      while (run.load(std::memory_order_relaxed)) {
+        for (std::size_t i = 0; i < sensor.size(); ++i) {
+          stamped s;
+          s.rail = static_cast<std::uint16_t>(first + i);
+          const std::uint64_t t0 = now_ns();
+          s.valid = sensor[i]->snapshot(s.sample);
+          const std::uint64_t t1 = now_ns();
+          s.time_ns = t0 + (t1 - t0) / 2;
+          if (!s.valid) {
+            bump(errors);
+          }
+          if (queue.push(s)) {
+            bump(samples);
+          } else {
+            bump(dropped);
+          }
+        }
+        if (period > 0) {
+          deadline += period;
+          std::this_thread::sleep_until(clock::time_point(
+            std::chrono::duration_cast<clock::duration>(
+              std::chrono::nanoseconds(deadline))));
+        }
+      }
+    }
+  };
+
+  const std::uint64_t                  _window;
+  std::vector<std::unique_ptr<worker>> _bus;
+  std::size_t                          _rails   = 0;
+  std::uint64_t                        _origin  = 0;
+  std::uint64_t                        _stopped = 0; // time of stop(), or 0 if running
+  std::uint64_t                        _current = 0;
+  frame                                _pending;
+  skew_stats                           _skew     = {};
+  double                               _skew_sum = 0.0;
+  std::uint64_t                        _skew_n   = 0;
+
+  std::uint64_t window_of(const stamped &s) const {
+    return (s.time_ns - _origin) / _window;
+  }
+
+  // Keep the most recent sample of each rail in the current window.
+  void accept(const stamped &s) {
+    auto &slot = _pending.rail[s.rail];
+    if (slot.time_ns == 0) {
+      ++_pending.present;
+    }
+    slot = s;
+  }
+
+  // Copy the pending frame to f, and reset the pending frame.
+  void emit(frame &f) {
+    std::uint64_t lo = UINT64_MAX, hi = 0;
+    for (const auto &s : _pending.rail) {
+      if (s.time_ns != 0) {
+        lo = s.time_ns < lo ? s.time_ns : lo;
+        hi = s.time_ns > hi ? s.time_ns : hi;
+      }
+    }
+    _pending.index = _current;
+    _pending.time_ns = _origin + _current * _window;
+    _pending.skew_ns = _pending.present > 1 ? hi - lo : 0;
+    ++_skew.frames;
+    if (_pending.present > 1) {
+      _skew_sum += static_cast<double>(_pending.skew_ns);
+      ++_skew_n;
+      _skew.max_ns = _pending.skew_ns > _skew.max_ns ? _pending.skew_ns : _skew.max_ns;
+      _skew.mean_ns = _skew_sum / static_cast<double>(_skew_n);
+    }
+    f.index = _pending.index;
+    f.time_ns = _pending.time_ns;
+    f.skew_ns = _pending.skew_ns;
+    f.present = _pending.present;
+    f.rail.assign(_pending.rail.begin(), _pending.rail.end());
+    for (auto &s : _pending.rail) {
+      s.time_ns = 0;
+    }
+    _pending.present = 0;
+  }
+};
+
+} // namespace acquire
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <cassert>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "pvc/i2c.hpp"
+
+// Coroutine support for non-blocking I²C operations (requires C++20).
+//
+// Sensor operations are written as coroutines returning async::task<T>, which
+// suspend while their transactions are in flight on a proto::AsyncI2C adapter.
+// A single-threaded async::executor resumes each coroutine once its transaction
+// completes, so that one thread can drive any number of outstanding operations
+// on many sensors, interleaved with other work scheduled on the same executor.
+// The pvc::async_* methods are only declared if PVC_ASYNC is defined as 1 (see
+// pvc.hpp).
+//
+//   async::executor exec;
+//   exec.spawn([](pvc<i2cdev::I2C> &sensor) -> async::task<> {
+//     ina260::sample sample;
+//     while (co_await sensor.async_snapshot(sample)) { ... }
+//   }(sensor));
+//   exec.run();
+namespace async {
+
+template <typename T = void>
+class task;
+
+// Single-threaded executor of coroutines.
+//
+// Coroutines are only ever resumed by the thread calling run(). Completions of
+// I²C operations may be delivered from any thread via post().
+class executor {
+public:
+  executor() = default;
+  executor(const executor &) = delete;
+  executor &operator=(const executor &) = delete;
+
+  // Return the executor running on the calling thread, or nullptr.
+  static executor *current() { return current_ref(); }
+
+  // Schedule the given coroutine to be resumed by run(). Thread-safe.
+  void post(const std::coroutine_handle<> handle) {
+    // Notify while holding the lock, since run() may return, and the executor
+    // be destroyed, as soon as the lock is released.
+    std::lock_guard<std::mutex> lock(_mutex);
+    _ready.push_back(handle);
+    _wake.notify_one();
+  }
+
+  // Return an awaitable that suspends the awaiting coroutine, and reschedules
+  // it after every coroutine already scheduled (i.e., yields).
+  auto schedule() {
+    struct awaiter {
+      executor *exec;
+      bool await_ready() const noexcept { return false; }
+      void await_suspend(const std::coroutine_handle<> h) const { exec->post(h); }
+      void await_resume() const noexcept {}
+    };
+    return awaiter{ this };
+  }
+
+  // Start the given task on this executor. The executor owns the task, which
+  // runs until completion; run() returns only once every spawned task has
+  // completed. Must be called from the thread calling run(), or before run().
+  void spawn(task<> &&t);
+
+  // Resume scheduled coroutines until every spawned task has completed.
+  void run() {
+    executor *const outer = current_ref();
+    current_ref() = this;
+    std::vector<std::coroutine_handle<>> batch;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _wake.wait(lock, [this] { return !_ready.empty() || _live == 0; });
+        if (_ready.empty()) {
+          break;
+        }
+        batch.swap(_ready);
+      }
+      for (auto h : batch) {
+        h.resume();
+      }
+      batch.clear();
+    }
+    current_ref() = outer;
+  }
+
+  // Number of spawned tasks that have not completed.
+  std::size_t live() const { return _live; }
+
+private:
+  std::mutex                           _mutex;
+  std::condition_variable              _wake;
+  std::vector<std::coroutine_handle<>> _ready;
+  std::size_t                          _live = 0; // accessed only by run() thread
+
+  static executor *&current_ref() {
+    static thread_local executor *exec = nullptr;
+    return exec;
+  }
+
+  // Coroutine that owns a spawned task, and destroys itself on completion.
+  struct detached {
+    struct promise_type {
+      detached get_return_object() noexcept { return {}; }
+      std::suspend_never initial_suspend() const noexcept { return {}; }
+      std::suspend_never final_suspend() const noexcept { return {}; }
+      void return_void() const noexcept {}
+      void unhandled_exception() const noexcept { std::terminate(); }
+    };
+  };
+
+  detached launch(task<> t);
+};
+
+namespace detail {
+
+template <typename T>
+struct promise_base {
+  std::coroutine_handle<> continuation;
+
+  // Resume the awaiting coroutine (if any) when the task completes.
+  struct final_awaiter {
+    bool await_ready() const noexcept { return false; }
+    template <typename P>
+    std::coroutine_handle<> await_suspend(const std::coroutine_handle<P> h) const noexcept {
+      const auto next = h.promise().continuation;
+      return next ? next : std::noop_coroutine();
+    }
+    void await_resume() const noexcept {}
+  };
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  final_awaiter final_suspend() const noexcept { return {}; }
+  void unhandled_exception() const noexcept { std::terminate(); }
+};
+
+template <typename T>
+struct promise: public promise_base<T> {
+  T value = {};
+  task<T> get_return_object() noexcept;
+  void return_value(T v) { value = std::move(v); }
+  T result() { return std::move(value); }
+};
+
+template <>
+struct promise<void>: public promise_base<void> {
+  task<void> get_return_object() noexcept;
+  void return_void() const noexcept {}
+  void result() const noexcept {}
+};
+
+} // namespace detail
+
+// Lazily-started coroutine that produces a value of type T.
+//
+// A task does not run until it is awaited (or spawned on an executor), and the
+// awaiting coroutine is resumed directly once the task completes.
+template <typename T>
+class task {
+public:
+  using promise_type = detail::promise<T>;
+  using handle_type  = std::coroutine_handle<promise_type>;
+
+  task() = default;
+  explicit task(const handle_type h) : _h(h) {}
+  task(task &&t) noexcept : _h(std::exchange(t._h, {})) {}
+  task &operator=(task &&t) noexcept {
+    if (this != &t) {
+      if (_h) { _h.destroy(); }
+      _h = std::exchange(t._h, {});
+    }
+    return *this;
+  }
+  task(const task &) = delete;
+  task &operator=(const task &) = delete;
+  ~task() { if (_h) { _h.destroy(); } }
+
+  // Return true if this task refers to a coroutine (i.e., it was returned by a
+  // coroutine, and was not moved from). Only valid tasks may be awaited; if
+  // assertions are disabled, awaiting an empty task yields T{} immediately.
+  bool valid() const noexcept { return static_cast<bool>(_h); }
+
+  bool await_ready() const noexcept {
+    assert(_h && "awaiting an empty task");
+    return !_h || _h.done();
+  }
+  std::coroutine_handle<> await_suspend(const std::coroutine_handle<> awaiting) noexcept {
+    _h.promise().continuation = awaiting;
+    return _h;
+  }
+  T await_resume() {
+    if (!_h) {
+      return T();
+    }
+    return _h.promise().result();
+  }
+
+private:
+  handle_type _h;
+};
+
+namespace detail {
+
+template <typename T>
+task<T> promise<T>::get_return_object() noexcept {
+  return task<T>(std::coroutine_handle<promise<T>>::from_promise(*this));
+}
+
+inline task<void> promise<void>::get_return_object() noexcept {
+  return task<void>(std::coroutine_handle<promise<void>>::from_promise(*this));
+}
+
+} // namespace detail
+
+inline void executor::spawn(task<> &&t) {
+  if (!t.valid()) {
+    return; // nothing to run
+  }
+  ++_live;
+  (void)launch(std::move(t));
+}
+
+inline executor::detached executor::launch(task<> t) {
+  co_await schedule();
+  co_await t;
+  --_live;
+}
+
+// Awaitable I²C operation on a proto::AsyncI2C adapter, which resumes the
+// awaiting coroutine on its executor with the number of bytes transferred.
+//
+// Must be awaited from a coroutine running on an executor; otherwise, or if the
+// operation cannot be submitted, it completes immediately with 0 bytes.
+class transfer {
+public:
+  transfer(proto::AsyncI2C *i2c, const bool write,
+    const std::uint8_t addr, std::uint8_t *data, const std::size_t size)
+    : _i2c(i2c), _write(write), _addr(addr), _data(data), _size(size) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  bool await_suspend(const std::coroutine_handle<> h) {
+    // The callback can only post to the executor, which cannot resume h before
+    // this function returns, since it is running on the executor's thread.
+    _exec = executor::current();
+    _handle = h;
+    if (_exec == nullptr) {
+      return false;
+    }
+    return _write
+      ? _i2c->write_async(_addr, _data, _size, &done, this)
+      : _i2c->read_async(_addr, _data, _size, &done, this);
+  }
+
+  std::size_t await_resume() const noexcept { return _count; }
+
+private:
+  proto::AsyncI2C         *_i2c;
+  bool                     _write;
+  std::uint8_t             _addr;
+  std::uint8_t            *_data;
+  std::size_t              _size;
+  std::size_t              _count  = 0;
+  executor                *_exec   = nullptr;
+  std::coroutine_handle<>  _handle = {};
+
+  static void done(void *context, const std::size_t count) {
+    auto *t = static_cast<transfer *>(context);
+    t->_count = count;
+    t->_exec->post(t->_handle);
+  }
+};
+
+// Read the given number of bytes from the specified memory address.
+inline transfer read(proto::AsyncI2C *i2c,
+  const std::uint8_t addr, std::uint8_t *data, const std::size_t size) {
+  return transfer(i2c, false, addr, data, size);
+}
+
+// Write data with the given number of bytes to the specified memory address.
+inline transfer write(proto::AsyncI2C *i2c,
+  const std::uint8_t addr, const std::uint8_t *data, const std::size_t size) {
+  // Written data is never modified by the adapter.
+  return transfer(i2c, true, addr, const_cast<std::uint8_t *>(data), size);
+}
+
+} // namespace async
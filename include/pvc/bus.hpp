@@ -0,0 +1,163 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "ina260.hpp"
+
+// I²C bus-time cost model and sampling-capacity planner.
+//
+// Estimates the wire time of every register operation for each supported bus
+// frequency (ina260::bus_freq_hz), and combines it with the conversion period
+// of each device (config::conversion_period_us) to determine whether a bus can
+// sustain the requested sample rates of a given set of devices.
+//
+// The model counts every clocked bit (8 data bits and 1 ACK/NACK bit per byte)
+// and adds the minimum START, repeated START, STOP, and bus-free times of the
+// I²C specification (NXP UM10204) for the bus mode. Controllers that stretch
+// these times, or insert gaps between bytes, will be slower than the model;
+// examples/host/bus_model.cpp compares the model with measured trace timings.
+namespace bus {
+
+// Minimum timing parameters (µs) of an I²C bus mode.
+struct mode {
+  std::uint32_t freq_hz;
+  double        t_hd_sta; // hold time of (repeated) START
+  double        t_su_sta; // setup time of repeated START
+  double        t_su_sto; // setup time of STOP
+  double        t_buf;    // bus free time between STOP and START
+  double        t_code;   // Hs-mode master code preamble, sent in Fm after every STOP
+
+  // Duration (µs) of the given number of clocked bits.
+  constexpr double bits(const std::uint32_t n) const {
+    return 1.0e6 * n / freq_hz;
+  }
+};
+
+// Timing of each supported bus frequency, in the same order as bus_freq_hz.
+// The Hs-mode master code is START + 8 bits + NACK at 400 kHz.
+constexpr std::array<mode, 4> modes = {{
+  { ina260::bus_freq_hz[0], 4.00, 4.70, 4.00, 4.70, 0.0 },
+  { ina260::bus_freq_hz[1], 0.60, 0.60, 0.60, 1.30, 0.0 },
+  { ina260::bus_freq_hz[2], 0.26, 0.26, 0.26, 0.50, 0.0 },
+  { ina260::bus_freq_hz[3], 0.16, 0.16, 0.16, 1.30, 0.60 + 1.0e6 * 9 / 400000 },
+}};
+
+// Return the timing of the bus mode used for the given frequency (Hz).
+constexpr mode mode_of(const std::uint32_t freq) {
+  const auto f = ina260::min_freq_hz(freq);
+  for (const auto &m : modes) {
+    if (m.freq_hz == f) {
+      return m;
+    }
+  }
+  return modes.back();
+}
+
+// Register access patterns, which depend on the I²C controller adapter.
+enum class op : std::uint8_t {
+  read_split    = 0x00, // pointer write, STOP, START, 2-byte read (e.g., Arduino)
+  read_repeated = 0x01, // pointer write, repeated START, 2-byte read (e.g., ESP-IDF)
+  read_cached   = 0x02, // 2-byte read of the register selected by the last access
+  write         = 0x03, // pointer write followed by 2 data bytes
+};
+
+// Number of bits clocked by each phase of a transaction.
+constexpr std::uint32_t addr_bits = 9;  // 7-bit address + R/W + ACK
+constexpr std::uint32_t byte_bits = 9;  // 8 data bits + ACK/NACK
+constexpr std::uint32_t word_bits = 18; // 2-byte register content
+
+// Return the wire time (µs) of one register operation at the given bus mode,
+// including the bus-free time that must follow it.
+constexpr double cost_us(const op access, const mode &m) {
+  // START ... STOP, followed by bus-free time, preceded by Hs master code.
+  const double frame = m.t_code + m.t_hd_sta + m.t_su_sto + m.t_buf;
+  switch (access) {
+    case op::read_split:
+      return 2 * frame + m.bits(addr_bits + byte_bits) + m.bits(addr_bits + word_bits);
+    case op::read_repeated:
+      return frame + m.t_su_sta + m.t_hd_sta +
+        m.bits(addr_bits + byte_bits + addr_bits + word_bits);
+    case op::read_cached:
+      return frame + m.bits(addr_bits + word_bits);
+    case op::write:
+      return frame + m.bits(addr_bits + byte_bits + word_bits);
+  }
+  return 0.0;
+}
+
+constexpr double cost_us(const op access, const std::uint32_t freq) {
+  return cost_us(access, mode_of(freq));
+}
+
+// How a device is sampled.
+struct plan {
+  ina260::config config  = ina260::config();
+  std::uint8_t   reads   = 3;                 // registers read per sample
+  op             access  = op::read_repeated; // access pattern of each read
+  double         rate_hz = 0.0;               // requested rate (0: once per conversion)
+};
+
+// Estimated performance of a single device.
+struct device_estimate {
+  double cost_us;      // bus time per sample
+  double period_us;    // conversion period (registers update interval)
+  double rate_hz;      // achievable sample rate
+  double staleness_us; // mean age of data when its read completes
+  double worst_us;     // worst-case age of data when its read completes
+};
+
+// Estimated performance of all devices sharing a bus.
+template <std::size_t N>
+struct estimate {
+  double cycle_us;     // bus time to sample every device once
+  double utilization;  // fraction of bus time required by the requested rates
+  double max_rate_hz;  // rate at which every device can be sampled back to back
+  double scale;        // fraction of the requested rates that is achievable
+  std::array<device_estimate, N> device;
+
+  constexpr bool feasible() const { return utilization <= 1.0; }
+};
+
+// Estimate the capacity of a bus at the given frequency shared by the devices
+// with the given sampling plans.
+//
+// A device is never usefully sampled faster than its conversion period, since
+// its registers would not change; a requested rate of 0 (or a faster rate) is
+// limited to one sample per conversion. If the requested rates would occupy
+// more than the entire bus (utilization > 1), every rate is scaled down by the
+// same factor.
+//
+// Reads are assumed unsynchronized with conversions, so the age of the data
+// returned is uniformly distributed over one conversion period, plus the time
+// to complete the read. In the worst case, a device also waits for every other
+// device to be read once.
+template <std::size_t N>
+constexpr estimate<N> capacity(const std::uint32_t freq,
+  const std::array<plan, N> &plans) {
+  const mode m = mode_of(freq);
+  estimate<N> e = {};
+  double load = 0.0;
+  for (std::size_t i = 0; i < N; ++i) {
+    auto &d = e.device[i];
+    d.cost_us = plans[i].reads * cost_us(plans[i].access, m);
+    d.period_us = plans[i].config.conversion_period_us();
+    const double limit = d.period_us > 0.0 ? 1.0e6 / d.period_us : 0.0;
+    d.rate_hz = (plans[i].rate_hz > 0.0 && plans[i].rate_hz < limit)
+      ? plans[i].rate_hz : limit;
+    e.cycle_us += d.cost_us;
+    load += d.rate_hz * d.cost_us;
+  }
+  e.utilization = load / 1.0e6;
+  e.max_rate_hz = e.cycle_us > 0.0 ? 1.0e6 / e.cycle_us : 0.0;
+  e.scale = e.utilization > 1.0 ? 1.0 / e.utilization : 1.0;
+  for (auto &d : e.device) {
+    d.rate_hz *= e.scale;
+    d.staleness_us = d.period_us / 2 + d.cost_us;
+    d.worst_us = d.period_us + e.cycle_us;
+  }
+  return e;
+}
+
+} // namespace bus
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "ina260.hpp"
+
+// Oscilloscope-style capture of transient events (inrush, brownout, etc.) that
+// are too brief to be noticed in averaged telemetry.
+namespace capture {
+
+// Condition that must be satisfied by a sample (or the ALERT function) for the
+// recorder to trigger.
+//
+// All levels are expressed in raw register units (LSB) of the selected channel
+// so that evaluating a trigger never requires any floating-point conversion.
+struct trigger {
+
+  enum class mode : std::uint8_t {
+    level   = 0x00, // channel value is at or above level
+    rising  = 0x01, // channel value crosses level from below
+    falling = 0x02, // channel value crosses level from above
+    slope   = 0x03, // change between consecutive samples exceeds level
+    alert   = 0x04, // ALERT function flag (masken.alert_function_flag()) is set
+    below   = 0x05, // channel value is at or below level (e.g., brownout)
+  };
+
+  mode                    how     = mode::rising;
+  ina260::config::op_type channel = ina260::config::op_type::current;
+
+  // Threshold in raw LSB of the channel. For mode::slope, a positive level
+  // triggers on a rise of at least level, and a negative level triggers on a
+  // fall of at least -level, between two consecutive samples. A slope trigger
+  // with level 0 never fires, since every sample would satisfy it.
+  std::int32_t level = 0;
+
+  // Return true if the transition from prev to curr satisfies this trigger.
+  constexpr bool fired(const std::int32_t prev, const std::int32_t curr,
+    const bool alert) const {
+    switch (how) {
+      case mode::level:
+        return curr >= level;
+      case mode::rising:
+        return prev < level && curr >= level;
+      case mode::falling:
+        return prev > level && curr <= level;
+      case mode::slope:
+        if (level > 0) { return curr - prev >= level; }
+        if (level < 0) { return curr - prev <= level; }
+        return false;
+      case mode::alert:
+        return alert;
+      case mode::below:
+        return curr <= level;
+    }
+    return false;
+  }
+
+}; // struct trigger
+
+// Records Pre samples preceding and Post samples following (and including) the
+// first sample that satisfies a trigger.
+//
+// Samples are continuously pushed into a fixed-size ring of pre-trigger
+// history. Once triggered, the history is copied into the record along with
+// the next Post samples, after which the record is frozen until rearm() is
+// called. The ring keeps recording while the record is frozen, so acquisition
+// never stops and a rearmed recorder already has a full pre-trigger history.
+//
+// All storage is contained in the object itself; push() never allocates.
+template <std::size_t Pre, std::size_t Post, typename T = ina260::sample>
+class recorder {
+public:
+  static_assert(Post > 0, "post-trigger capture must include the trigger sample");
+
+  using sample_type = T;
+  using record_type = std::array<sample_type, Pre + Post>;
+
+  enum class state : std::uint8_t {
+    idle      = 0x00, // not armed; samples only fill the pre-trigger ring
+    armed     = 0x01, // waiting for the trigger condition
+    capturing = 0x02, // triggered; filling post-trigger samples
+    frozen    = 0x03, // record complete; waiting for rearm()
+  };
+
+  constexpr recorder(const capture::trigger &trigger = capture::trigger())
+    : _trigger(trigger) {}
+
+  const capture::trigger &trigger() const { return _trigger; }
+  state status() const { return _state; }
+  bool frozen() const { return _state == state::frozen; }
+
+  // Change the trigger condition. Takes effect at the next push().
+  void set_trigger(const capture::trigger &trigger) { _trigger = trigger; }
+
+  // Start waiting for the trigger condition, discarding any frozen record.
+  void arm() {
+    _state = state::armed;
+    _post = 0;
+  }
+
+  // Stop waiting for the trigger condition, discarding any frozen record.
+  void disarm() {
+    _state = state::idle;
+    _post = 0;
+  }
+
+  // Release a frozen record and wait for the next trigger.
+  void rearm() { arm(); }
+
+  // Add a sample to the pre-trigger ring, and evaluate the trigger if armed.
+  //
+  // The alert flag should be the ALERT function flag read from the MASK/ENABLE
+  // register (masken.alert_function_flag()) for the same conversion, or false if
+  // it was not read. It is only used by trigger::mode::alert.
+  //
+  // Returns true if the record was frozen by this sample.
+  bool push(const sample_type &sample, const bool alert = false) {
+    const bool was_frozen = frozen();
+    const std::int32_t curr = sample.value(_trigger.channel);
+    switch (_state) {
+      case state::armed:
+        // The first sample has no predecessor, so it cannot form an edge/slope.
+        if (_trigger.fired(_count > 0 ? _prev : curr, curr, alert)) {
+          trigger_on(sample);
+        }
+        break;
+      case state::capturing:
+        _record[Pre + _post++] = sample;
+        if (_post == Post) {
+          _state = state::frozen;
+        }
+        break;
+      default:
+        break;
+    }
+    if constexpr (Pre > 0) {
+      _ring[_head] = sample;
+      _head = (_head + 1 == Pre) ? 0 : _head + 1;
+    }
+    _prev = curr;
+    ++_count;
+    return !was_frozen && frozen();
+  }
+
+  // Return the captured record: pre_count() samples of pre-trigger history,
+  // ending at index Pre - 1, followed by Post samples beginning with the
+  // trigger sample at index Pre. The content is only complete when frozen().
+  const record_type &record() const { return _record; }
+
+  // Return the number of valid pre-trigger samples in the record, which is less
+  // than Pre if the trigger fired before the ring was completely filled.
+  std::size_t pre_count() const { return _pre; }
+
+  // Return the sequence number (zero-based count of all samples pushed) of the
+  // trigger sample, which can be used to recover its acquisition time.
+  std::uint64_t trigger_index() const { return _index; }
+
+  // Return the total number of samples pushed since construction.
+  std::uint64_t count() const { return _count; }
+
+private:
+  capture::trigger _trigger;
+  state            _state = state::idle;
+
+  std::array<sample_type, Pre> _ring   = {};
+  record_type                  _record = {};
+
+  std::size_t   _head  = 0; // next write position in _ring
+  std::size_t   _pre   = 0; // valid pre-trigger samples in _record
+  std::size_t   _post  = 0; // post-trigger samples captured in _record
+  std::int32_t  _prev  = 0; // channel value of the previous sample
+  std::uint64_t _count = 0; // total samples pushed
+  std::uint64_t _index = 0; // sequence number of the trigger sample
+
+  // Copy the pre-trigger history (oldest first) and the trigger sample into
+  // the record. This is the only non-constant-time step, bounded by Pre.
+  void trigger_on(const sample_type &sample) {
+    _pre = _count < Pre ? static_cast<std::size_t>(_count) : Pre;
+    std::size_t from = (_head + Pre - _pre) % (Pre > 0 ? Pre : 1);
+    for (std::size_t i = 0; i < _pre; ++i) {
+      _record[Pre - _pre + i] = _ring[from];
+      from = (from + 1 == Pre) ? 0 : from + 1;
+    }
+    _record[Pre] = sample;
+    _post = 1;
+    _index = _count;
+    _state = (_post == Post) ? state::frozen : state::capturing;
+  }
+};
+
+} // namespace capture
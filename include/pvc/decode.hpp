@@ -0,0 +1,306 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PVC_DECODE_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PVC_DECODE_SSE2 1
+#elif defined(__ARM_NEON) && !defined(__ARM_BIG_ENDIAN)
+#include <arm_neon.h>
+#define PVC_DECODE_NEON 1
+#endif
+
+#include "ina260.hpp"
+
+// Bulk conversion of raw register captures to physical units.
+//
+// Input is an array of raw 16-bit register words of a single measurement
+// channel, exactly as transferred on the bus (big-endian, most-significant byte
+// first in memory), such as those recorded by a logic analyzer or stored by an
+// acquisition node without decoding. Each function byte-swaps, sign-extends
+// the CURRENT register (two's complement), and scales by the channel's LSB.
+//
+// Floating-point output is in the sensor's native units (mV, mA, mW) like the
+// pvc measurement methods. Fixed-point output is in µV, µA, µW as std::int32_t,
+// which is exact for every register value.
+//
+// The widest SIMD kernel enabled by the compiler flags (AVX2, SSE2, or NEON) is
+// selected at compile time. The portable scalar kernels in decode::scalar are
+// always available, and are used for any remaining elements.
+namespace decode {
+
+using op_type = ina260::config::op_type;
+
+// Return the floating-point scale (native units per LSB) of the given channel.
+constexpr float scale_of(const op_type type) {
+  switch (type) {
+    case op_type::current: return static_cast<float>(ina260::lsb_current);
+    case op_type::voltage: return static_cast<float>(ina260::lsb_voltage);
+    case op_type::power:   return static_cast<float>(ina260::lsb_power);
+    default:               return 0.0F;
+  }
+}
+
+// Return the fixed-point scale (micro-units per LSB) of the given channel.
+constexpr std::int32_t micro_of(const op_type type) {
+  return static_cast<std::int32_t>(scale_of(type) * 1000.0F);
+}
+
+// Return the host-order value of a raw big-endian register word.
+inline std::uint16_t word(const std::uint16_t &raw) {
+  const auto *const b = reinterpret_cast<const std::uint8_t *>(&raw);
+  return static_cast<std::uint16_t>((b[0] << 8) | b[1]);
+}
+
+namespace scalar {
+
+inline void to_float(const op_type type,
+  const std::uint16_t *const raw, float *const out, const std::size_t size) {
+  const float scale = scale_of(type);
+  if (type == op_type::current) {
+    for (std::size_t k = 0; k < size; ++k) {
+      out[k] = scale * static_cast<std::int16_t>(word(raw[k]));
+    }
+  } else {
+    for (std::size_t k = 0; k < size; ++k) {
+      out[k] = scale * word(raw[k]);
+    }
+  }
+}
+
+inline void to_fixed(const op_type type,
+  const std::uint16_t *const raw, std::int32_t *const out, const std::size_t size) {
+  const std::int32_t scale = micro_of(type);
+  if (type == op_type::current) {
+    for (std::size_t k = 0; k < size; ++k) {
+      out[k] = scale * static_cast<std::int16_t>(word(raw[k]));
+    }
+  } else {
+    for (std::size_t k = 0; k < size; ++k) {
+      out[k] = scale * static_cast<std::int32_t>(word(raw[k]));
+    }
+  }
+}
+
+} // namespace scalar
+
+namespace simd {
+
+#if defined(PVC_DECODE_AVX2)
+
+constexpr std::size_t width = 16;
+
+inline __m256i swap16(const __m256i v) {
+  const __m256i mask = _mm256_setr_epi8(
+    1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+    1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+  return _mm256_shuffle_epi8(v, mask);
+}
+
+// Widen 16 host-order words to two vectors of 8 × 32-bit integers.
+template <bool Signed>
+inline void widen(const __m256i v, __m256i &lo, __m256i &hi) {
+  const __m128i a = _mm256_castsi256_si128(v);
+  const __m128i b = _mm256_extracti128_si256(v, 1);
+  if constexpr (Signed) {
+    lo = _mm256_cvtepi16_epi32(a);
+    hi = _mm256_cvtepi16_epi32(b);
+  } else {
+    lo = _mm256_cvtepu16_epi32(a);
+    hi = _mm256_cvtepu16_epi32(b);
+  }
+}
+
+template <bool Signed>
+inline std::size_t to_float(const std::uint16_t *const raw, float *const out,
+  const std::size_t size, const float scale) {
+  const __m256 s = _mm256_set1_ps(scale);
+  std::size_t k = 0;
+  for (; k + width <= size; k += width) {
+    __m256i lo, hi;
+    widen<Signed>(swap16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(raw + k))), lo, hi);
+    _mm256_storeu_ps(out + k,     _mm256_mul_ps(_mm256_cvtepi32_ps(lo), s));
+    _mm256_storeu_ps(out + k + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), s));
+  }
+  return k;
+}
+
+template <bool Signed>
+inline std::size_t to_fixed(const std::uint16_t *const raw, std::int32_t *const out,
+  const std::size_t size, const std::int32_t scale) {
+  const __m256i s = _mm256_set1_epi32(scale);
+  std::size_t k = 0;
+  for (; k + width <= size; k += width) {
+    __m256i lo, hi;
+    widen<Signed>(swap16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(raw + k))), lo, hi);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + k),     _mm256_mullo_epi32(lo, s));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + k + 8), _mm256_mullo_epi32(hi, s));
+  }
+  return k;
+}
+
+#elif defined(PVC_DECODE_SSE2)
+
+constexpr std::size_t width = 8;
+
+inline __m128i swap16(const __m128i v) {
+  return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+// Widen 8 host-order words to two vectors of 4 × 32-bit integers.
+template <bool Signed>
+inline void widen(const __m128i v, __m128i &lo, __m128i &hi) {
+  if constexpr (Signed) {
+    lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+  } else {
+    const __m128i zero = _mm_setzero_si128();
+    lo = _mm_unpacklo_epi16(v, zero);
+    hi = _mm_unpackhi_epi16(v, zero);
+  }
+}
+
+template <bool Signed>
+inline std::size_t to_float(const std::uint16_t *const raw, float *const out,
+  const std::size_t size, const float scale) {
+  const __m128 s = _mm_set1_ps(scale);
+  std::size_t k = 0;
+  for (; k + width <= size; k += width) {
+    __m128i lo, hi;
+    widen<Signed>(swap16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(raw + k))), lo, hi);
+    _mm_storeu_ps(out + k,     _mm_mul_ps(_mm_cvtepi32_ps(lo), s));
+    _mm_storeu_ps(out + k + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), s));
+  }
+  return k;
+}
+
+// SSE2 has no 32-bit multiply, but every scale fits in 16 bits, so the full
+// 32-bit products are assembled from the low and high 16-bit halves.
+template <bool Signed>
+inline std::size_t to_fixed(const std::uint16_t *const raw, std::int32_t *const out,
+  const std::size_t size, const std::int32_t scale) {
+  const __m128i s = _mm_set1_epi16(static_cast<std::int16_t>(scale));
+  std::size_t k = 0;
+  for (; k + width <= size; k += width) {
+    const __m128i v = swap16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(raw + k)));
+    const __m128i pl = _mm_mullo_epi16(v, s);
+    const __m128i ph = Signed ? _mm_mulhi_epi16(v, s) : _mm_mulhi_epu16(v, s);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + k),     _mm_unpacklo_epi16(pl, ph));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + k + 4), _mm_unpackhi_epi16(pl, ph));
+  }
+  return k;
+}
+
+#elif defined(PVC_DECODE_NEON)
+
+constexpr std::size_t width = 8;
+
+inline uint16x8_t swap16(const uint16x8_t v) {
+  return vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(v)));
+}
+
+// Widen 8 host-order words to two vectors of 4 × 32-bit integers.
+template <bool Signed>
+inline void widen(const uint16x8_t v, int32x4_t &lo, int32x4_t &hi) {
+  if constexpr (Signed) {
+    const int16x8_t s = vreinterpretq_s16_u16(v);
+    lo = vmovl_s16(vget_low_s16(s));
+    hi = vmovl_s16(vget_high_s16(s));
+  } else {
+    lo = vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(v)));
+    hi = vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(v)));
+  }
+}
+
+template <bool Signed>
+inline std::size_t to_float(const std::uint16_t *const raw, float *const out,
+  const std::size_t size, const float scale) {
+  std::size_t k = 0;
+  for (; k + width <= size; k += width) {
+    int32x4_t lo, hi;
+    widen<Signed>(swap16(vld1q_u16(raw + k)), lo, hi);
+    vst1q_f32(out + k,     vmulq_n_f32(vcvtq_f32_s32(lo), scale));
+    vst1q_f32(out + k + 4, vmulq_n_f32(vcvtq_f32_s32(hi), scale));
+  }
+  return k;
+}
+
+template <bool Signed>
+inline std::size_t to_fixed(const std::uint16_t *const raw, std::int32_t *const out,
+  const std::size_t size, const std::int32_t scale) {
+  std::size_t k = 0;
+  for (; k + width <= size; k += width) {
+    int32x4_t lo, hi;
+    widen<Signed>(swap16(vld1q_u16(raw + k)), lo, hi);
+    vst1q_s32(out + k,     vmulq_n_s32(lo, scale));
+    vst1q_s32(out + k + 4, vmulq_n_s32(hi, scale));
+  }
+  return k;
+}
+
+#else
+
+constexpr std::size_t width = 1;
+
+template <bool Signed>
+inline std::size_t to_float(const std::uint16_t *const, float *const,
+  const std::size_t, const float) { return 0; }
+
+template <bool Signed>
+inline std::size_t to_fixed(const std::uint16_t *const, std::int32_t *const,
+  const std::size_t, const std::int32_t) { return 0; }
+
+#endif
+
+} // namespace simd
+
+// Convert the given number of raw big-endian register words of the given
+// channel to floating-point native units (mV, mA, mW).
+inline void to_float(const op_type type,
+  const std::uint16_t *const raw, float *const out, const std::size_t size) {
+  const std::size_t k = (type == op_type::current)
+    ? simd::to_float<true>(raw, out, size, scale_of(type))
+    : simd::to_float<false>(raw, out, size, scale_of(type));
+  scalar::to_float(type, raw + k, out + k, size - k);
+}
+
+// Convert the given number of raw big-endian register words of the given
+// channel to fixed-point micro-units (µV, µA, µW).
+inline void to_fixed(const op_type type,
+  const std::uint16_t *const raw, std::int32_t *const out, const std::size_t size) {
+  const std::size_t k = (type == op_type::current)
+    ? simd::to_fixed<true>(raw, out, size, micro_of(type))
+    : simd::to_fixed<false>(raw, out, size, micro_of(type));
+  scalar::to_fixed(type, raw + k, out + k, size - k);
+}
+
+// Verify the consistency of captured POWER registers with the product of the
+// corresponding BUS_VOLTAGE and CURRENT registers, and return the number of
+// samples whose power differs from |V · I| by more than the given tolerance
+// (mW). The device computes power from the magnitude of current, and rounds
+// it to the nearest power LSB, so a tolerance below lsb_power reports
+// spurious mismatches.
+inline std::size_t power_check(
+  const std::uint16_t *const voltage,
+  const std::uint16_t *const current,
+  const std::uint16_t *const power,
+  const std::size_t size,
+  const float tolerance = static_cast<float>(ina260::lsb_power)) {
+  constexpr float vi = static_cast<float>(
+    ina260::lsb_voltage * ina260::lsb_current / 1000.0);
+  constexpr float p = static_cast<float>(ina260::lsb_power);
+  std::size_t mismatch = 0;
+  for (std::size_t k = 0; k < size; ++k) {
+    const float v = word(voltage[k]);
+    const std::int32_t c = static_cast<std::int16_t>(word(current[k]));
+    const float d = vi * v * static_cast<float>(c < 0 ? -c : c) - p * word(power[k]);
+    mismatch += (d > tolerance || d < -tolerance) ? 1 : 0;
+  }
+  return mismatch;
+}
+
+} // namespace decode
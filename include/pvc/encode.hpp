@@ -0,0 +1,505 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+#include "ina260.hpp"
+
+// Allocation-free serialization of samples and register states into
+// caller-provided buffers.
+//
+// Text encoders format raw register values directly with integer arithmetic
+// (the LSB of each channel is an exact decimal fraction), so no floating-point
+// formatting or heap allocation is ever performed. Unit strings are taken from
+// the constexpr tables of ina260::config.
+//
+// Every encoder returns the number of bytes written, or 0 if the buffer is too
+// small, in which case the buffer content is unspecified. No terminating null
+// character is written.
+namespace encode {
+
+namespace detail {
+
+using op_type = ina260::config::op_type;
+
+// Output cursor. If Checked is false, the caller guarantees that the buffer
+// has room for the longest possible output, and all bounds checks are elided.
+template <bool Checked = true>
+struct writer {
+  char *const       buf;
+  const std::size_t size;
+  std::size_t       pos = 0;
+  bool              ok  = true;
+
+  bool room(const std::size_t n) {
+    if constexpr (Checked) {
+      if (n > size - pos) {
+        ok = false;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void put(const char c) {
+    if (room(1)) { buf[pos++] = c; }
+  }
+
+  void put(const std::string_view s) {
+    if (room(s.size())) {
+      std::memcpy(buf + pos, s.data(), s.size());
+      pos += s.size();
+    }
+  }
+
+  static constexpr char digits[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+  // Copy the two digits of v < 100 to p.
+  static void pair(char *const p, const std::uint32_t v) {
+    std::memcpy(p, digits + v * 2, 2);
+  }
+
+  // Format an unsigned integer below 10^8.
+  void small(std::uint32_t v) {
+    const unsigned n =
+      v < 10U ? 1 : v < 100U ? 2 : v < 1000U ? 3 : v < 10000U ? 4 :
+      v < 100000U ? 5 : v < 1000000U ? 6 : v < 10000000U ? 7 : 8;
+    if (!room(n)) {
+      return;
+    }
+    pos += n;
+    char *end = buf + pos;
+    for (; v >= 100; v /= 100) {
+      end -= 2;
+      pair(end, v % 100);
+    }
+    if (v >= 10) {
+      pair(end - 2, v);
+    } else {
+      end[-1] = static_cast<char>('0' + v);
+    }
+  }
+
+  // Format exactly eight digits of v < 10^8, using 32-bit arithmetic only.
+  void eight(const std::uint32_t v) {
+    if (!room(8)) {
+      return;
+    }
+    char *const p = buf + pos;
+    pos += 8;
+    const std::uint32_t hi = v / 10000, lo = v % 10000;
+    pair(p, hi / 100);
+    pair(p + 2, hi % 100);
+    pair(p + 4, lo / 100);
+    pair(p + 6, lo % 100);
+  }
+
+  // Format an unsigned integer. Large values (e.g., nanosecond timestamps) are
+  // split into fixed-width groups of eight digits, so that each 64-bit
+  // division is by a constant and the digit count is found by comparisons.
+  void put(const std::uint64_t v) {
+    constexpr std::uint64_t e8 = 100000000U;
+    if (v < e8) {
+      small(static_cast<std::uint32_t>(v));
+      return;
+    }
+    const std::uint64_t q = v / e8;
+    if (q < e8) {
+      small(static_cast<std::uint32_t>(q));
+    } else {
+      small(static_cast<std::uint32_t>(q / e8));
+      eight(static_cast<std::uint32_t>(q % e8));
+    }
+    eight(static_cast<std::uint32_t>(v % e8));
+  }
+
+  // Format the least-significant digits of an unsigned integer, zero-padded
+  // to exactly the given width.
+  void put(std::uint64_t v, const unsigned width) {
+    if (!room(width)) {
+      return;
+    }
+    pos += width;
+    for (unsigned i = 1; i <= width; ++i, v /= 10) {
+      buf[pos - i] = static_cast<char>('0' + v % 10);
+    }
+  }
+
+  void hex(const std::uint8_t v) {
+    static constexpr char hex_digits[] = "0123456789abcdef";
+    put('0'); put('x');
+    put(hex_digits[v >> 4]); put(hex_digits[v & 0x0F]);
+  }
+};
+
+constexpr std::uint64_t pow10(const unsigned n) {
+  std::uint64_t p = 1;
+  for (unsigned i = 0; i < n; ++i) {
+    p *= 10;
+  }
+  return p;
+}
+
+// Return the LSB of the given channel, in native units (mV, mA, mW).
+constexpr double lsb_of(const op_type type) {
+  switch (type) {
+    case op_type::current: return ina260::lsb_current;
+    case op_type::voltage: return ina260::lsb_voltage;
+    case op_type::power:   return ina260::lsb_power;
+    default:               return 0.0;
+  }
+}
+
+// Return true if the LSB of the given channel is an integer multiple of
+// 10^-places native units, so that values can be printed exactly.
+constexpr bool exact(const op_type type, const unsigned places) {
+  const double scaled = lsb_of(type) * static_cast<double>(pow10(places));
+  return scaled == static_cast<double>(static_cast<std::uint64_t>(scaled));
+}
+
+// Fixed-point format of a channel: each LSB is lsb units of 10^-places.
+struct format {
+  std::uint64_t lsb;
+  std::uint64_t unit; // 10^places
+  unsigned      places;
+};
+
+// Return the format of the given channel with the given decimal places, in
+// native units (mV, mA, mW), or in base units (V, A, W) if base is true.
+constexpr format format_of(const op_type type, const unsigned places, const bool base) {
+  const unsigned lsb_places = base ? places - 3 : places; // native units are milli
+  return { static_cast<std::uint64_t>(lsb_of(type) * static_cast<double>(pow10(lsb_places))),
+    pow10(places), places };
+}
+
+// Formats of each channel, indexed by op_type - 1 (current, voltage, power).
+// Voltage and current are printed with two decimal places in native units, and
+// power as an integer; all channels have five decimal places in base units.
+constexpr format native_format[3] = {
+  format_of(op_type::current, 2, false),
+  format_of(op_type::voltage, 2, false),
+  format_of(op_type::power,   0, false),
+};
+constexpr format base_format[3] = {
+  format_of(op_type::current, 5, true),
+  format_of(op_type::voltage, 5, true),
+  format_of(op_type::power,   5, true),
+};
+
+static_assert(exact(op_type::current, 2) && exact(op_type::voltage, 2) &&
+  exact(op_type::power, 0) && exact(op_type::current, 5 - 3) &&
+  exact(op_type::voltage, 5 - 3) && exact(op_type::power, 5 - 3),
+  "LSB is not an exact decimal fraction at the printed precision");
+
+constexpr std::size_t index_of(const op_type type) {
+  return static_cast<std::size_t>(type) - 1;
+}
+
+// Format the given raw measurement of channel T, in base units if Base is
+// true, otherwise in native units. The format is a compile-time constant, so
+// that all scaling is by constant multiplication and division.
+template <op_type T, bool Base, typename W>
+void measurement(W &w, const std::int32_t raw) {
+  constexpr format f = Base ? base_format[index_of(T)] : native_format[index_of(T)];
+  std::uint64_t mag = static_cast<std::uint64_t>(raw < 0 ? -std::int64_t{raw} : raw);
+  if (raw < 0) {
+    w.put('-');
+  }
+  mag *= f.lsb;
+  if constexpr (f.places == 0) {
+    w.put(mag);
+  } else {
+    w.put(mag / f.unit);
+    w.put('.');
+    w.put(mag % f.unit, f.places);
+  }
+}
+
+// Field key of a channel in native units (e.g., "voltage_mV"), composed at
+// compile time from the ina260::config tables.
+struct key {
+  char        str[24];
+  std::size_t size;
+
+  constexpr std::string_view view() const { return { str, size }; }
+
+  constexpr key &append(const std::string_view s) {
+    for (const char c : s) {
+      str[size++] = c;
+    }
+    return *this;
+  }
+};
+
+constexpr key key_of(const op_type type) {
+  key k = {};
+  return k.append(ina260::config::value_of_key(type)).append("_")
+    .append(ina260::config::units_prefix)
+    .append(ina260::config::to_base_units(type));
+}
+
+// Call the given function with each channel (voltage, current, power), as a
+// std::integral_constant so that the channel is a compile-time constant.
+template <typename F>
+void for_each_channel(F &&f) {
+  f(std::integral_constant<op_type, op_type::voltage>());
+  f(std::integral_constant<op_type, op_type::current>());
+  f(std::integral_constant<op_type, op_type::power>());
+}
+
+// Plural base unit names, as required for OpenMetrics metric names.
+constexpr ina260::pairs_type<op_type, std::string_view, 3> base_unit_names = {{
+  {op_type::current, std::string_view("amperes")},
+  {op_type::voltage, std::string_view("volts")},
+  {op_type::power, std::string_view("watts")}
+}};
+
+constexpr std::string_view base_unit_name(const op_type type) {
+  return ina260::value_of_key(type, base_unit_names, std::string_view("unknown"));
+}
+
+// Run the given formatting function with a writer over the given buffer, and
+// return the number of bytes written, or 0 if the buffer was too small. When
+// the buffer has room for bound bytes, formatting runs without bounds checks.
+template <typename F>
+std::size_t encode(char *const buf, const std::size_t size,
+  const std::size_t bound, F &&format) {
+  if (size >= bound) {
+    writer<false> w{buf, size};
+    format(w);
+    return w.pos;
+  }
+  writer<true> w{buf, size};
+  format(w);
+  return w.ok ? w.pos : 0;
+}
+
+} // namespace detail
+
+// Default measurement name used by the text encoders.
+constexpr std::string_view default_name = "pvc";
+
+// Encode a sample in InfluxDB line protocol, with one field per channel named
+// by its type and native units. The timestamp (ns) is omitted if zero.
+//
+//   pvc,addr=0x40 voltage_mV=12000.00,current_mA=-1000.00,power_mW=12000 1700000000000000000
+inline std::size_t line(char *const buf, const std::size_t size,
+  const ina260::sample &sample, const std::uint8_t addr,
+  const std::uint64_t time_ns = 0, const std::string_view name = default_name) {
+  return detail::encode(buf, size, name.size() + 96, [&](auto &w) {
+    w.put(name);
+    w.put(",addr=");
+    w.hex(addr);
+    char sep = ' ';
+    detail::for_each_channel([&](auto type) {
+      static constexpr detail::key k = detail::key_of(type);
+      w.put(sep);
+      w.put(k.view());
+      w.put('=');
+      detail::measurement<type, false>(w, sample.value(type));
+      sep = ',';
+    });
+    if (time_ns != 0) {
+      w.put(' ');
+      w.put(time_ns);
+    }
+    w.put('\n');
+  });
+}
+
+// Encode the register state of a device in InfluxDB line protocol, with each
+// register as an integer field.
+//
+//   pvc_reg,addr=0x40 config=295i,masken=0i,alimit=0i 1700000000000000000
+inline std::size_t line(char *const buf, const std::size_t size,
+  const ina260::config &config, const ina260::masken &masken,
+  const ina260::alimit &alimit, const std::uint8_t addr,
+  const std::uint64_t time_ns = 0, const std::string_view name = default_name) {
+  return detail::encode(buf, size, name.size() + 80, [&](auto &w) {
+    w.put(name);
+    w.put("_reg,addr=");
+    w.hex(addr);
+    w.put(" config=");
+    w.put(std::uint64_t{config.u16});
+    w.put("i,masken=");
+    w.put(std::uint64_t{masken.u16});
+    w.put("i,alimit=");
+    w.put(std::uint64_t{alimit.u16});
+    w.put('i');
+    if (time_ns != 0) {
+      w.put(' ');
+      w.put(time_ns);
+    }
+    w.put('\n');
+  });
+}
+
+// Encode the samples of n devices as a complete OpenMetrics text exposition:
+// one gauge family per channel in base units, with one metric point per device
+// labeled by address, followed by the "# EOF" terminator. The timestamp (ns)
+// is printed in seconds, and omitted if zero.
+//
+//   # TYPE pvc_voltage_volts gauge
+//   # UNIT pvc_voltage_volts volts
+//   pvc_voltage_volts{addr="0x40"} 12.00000 1700000000.000000000
+//   ...
+//   # EOF
+inline std::size_t openmetrics(char *const buf, const std::size_t size,
+  const ina260::sample *const sample, const std::uint8_t *const addr,
+  const std::size_t n, const std::uint64_t time_ns = 0,
+  const std::string_view name = default_name) {
+  const std::size_t bound = 3 * (2 * name.size() + 64) + 3 * n * (name.size() + 80) + 8;
+  return detail::encode(buf, size, bound, [&](auto &w) {
+    detail::for_each_channel([&](auto type) {
+      const auto family = [&] {
+        w.put(name);
+        w.put('_');
+        w.put(ina260::config::value_of_key(type));
+        w.put('_');
+        w.put(detail::base_unit_name(type));
+      };
+      w.put("# TYPE ");
+      family();
+      w.put(" gauge\n# UNIT ");
+      family();
+      w.put(' ');
+      w.put(detail::base_unit_name(type));
+      w.put('\n');
+      for (std::size_t i = 0; i < n; ++i) {
+        family();
+        w.put("{addr=\"");
+        w.hex(addr[i]);
+        w.put("\"} ");
+        detail::measurement<type, true>(w, sample[i].value(type));
+        if (time_ns != 0) {
+          w.put(' ');
+          w.put(time_ns / 1000000000U);
+          w.put('.');
+          w.put(time_ns % 1000000000U, 9);
+        }
+        w.put('\n');
+      }
+    });
+    w.put("# EOF\n");
+  });
+}
+
+// Encode a sample of a single device as a complete OpenMetrics exposition.
+inline std::size_t openmetrics(char *const buf, const std::size_t size,
+  const ina260::sample &sample, const std::uint8_t addr,
+  const std::uint64_t time_ns = 0, const std::string_view name = default_name) {
+  return openmetrics(buf, size, &sample, &addr, 1, time_ns, name);
+}
+
+// Fixed-layout binary frame, all integers little-endian:
+//
+//   offset  size  field
+//        0     1  magic (0xA5)
+//        1     1  kind (frame::kind)
+//        2     1  device address
+//        3     1  sequence number (wraps)
+//        4     8  timestamp (user-defined units, e.g., ns)
+//       12     2  voltage | config
+//       14     2  current | masken
+//       16     2  power   | alimit
+//       18     2  Fletcher-16 checksum of bytes 0 – 17
+struct frame {
+  static constexpr std::size_t  size  = 20;
+  static constexpr std::uint8_t magic = 0xA5;
+
+  enum class kind : std::uint8_t {
+    sample    = 0x01, // words are ina260::sample (voltage, current, power)
+    registers = 0x02, // words are config, masken, alimit
+  };
+
+  kind          type;
+  std::uint8_t  addr;
+  std::uint8_t  seq;
+  std::uint64_t time;
+  std::uint16_t word[3];
+
+  ina260::sample sample() const { return { word[0], word[1], word[2] }; }
+  ina260::config config() const { return ina260::config(word[0]); }
+  ina260::masken masken() const { return ina260::masken(word[1]); }
+  ina260::alimit alimit() const { return ina260::alimit(word[2]); }
+
+  // Fletcher-16 checksum. The sums of a frame cannot overflow 32 bits, so the
+  // modulo is only taken once, at the end.
+  static constexpr std::uint16_t checksum(const std::uint8_t *const p, const std::size_t n) {
+    std::uint32_t a = 0, b = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      a += p[i];
+      b += a;
+    }
+    return static_cast<std::uint16_t>(((b % 255) << 8) | (a % 255));
+  }
+
+  // Serialize this frame into the given buffer.
+  std::size_t write(std::uint8_t *const buf, const std::size_t len) const {
+    if (len < size) {
+      return 0;
+    }
+    buf[0] = magic;
+    buf[1] = static_cast<std::uint8_t>(type);
+    buf[2] = addr;
+    buf[3] = seq;
+    for (std::size_t i = 0; i < 8; ++i) {
+      buf[4 + i] = static_cast<std::uint8_t>(time >> (i * 8));
+    }
+    for (std::size_t i = 0; i < 3; ++i) {
+      buf[12 + i * 2] = static_cast<std::uint8_t>(word[i]);
+      buf[13 + i * 2] = static_cast<std::uint8_t>(word[i] >> 8);
+    }
+    const std::uint16_t sum = checksum(buf, 18);
+    buf[18] = static_cast<std::uint8_t>(sum);
+    buf[19] = static_cast<std::uint8_t>(sum >> 8);
+    return size;
+  }
+
+  // Deserialize a frame from the given buffer. Returns false if the buffer is
+  // too small, or the magic or checksum do not match.
+  bool read(const std::uint8_t *const buf, const std::size_t len) {
+    if (len < size || buf[0] != magic ||
+        checksum(buf, 18) != (buf[18] | (buf[19] << 8))) {
+      return false;
+    }
+    type = static_cast<kind>(buf[1]);
+    addr = buf[2];
+    seq  = buf[3];
+    time = 0;
+    for (std::size_t i = 0; i < 8; ++i) {
+      time |= static_cast<std::uint64_t>(buf[4 + i]) << (i * 8);
+    }
+    for (std::size_t i = 0; i < 3; ++i) {
+      word[i] = static_cast<std::uint16_t>(buf[12 + i * 2] | (buf[13 + i * 2] << 8));
+    }
+    return true;
+  }
+};
+
+// Encode a sample as a binary frame.
+inline std::size_t binary(std::uint8_t *const buf, const std::size_t size,
+  const ina260::sample &sample, const std::uint8_t addr,
+  const std::uint64_t time = 0, const std::uint8_t seq = 0) {
+  const frame f = { frame::kind::sample, addr, seq, time,
+    { sample.voltage, sample.current, sample.power } };
+  return f.write(buf, size);
+}
+
+// Encode the register state of a device as a binary frame.
+inline std::size_t binary(std::uint8_t *const buf, const std::size_t size,
+  const ina260::config &config, const ina260::masken &masken,
+  const ina260::alimit &alimit, const std::uint8_t addr,
+  const std::uint64_t time = 0, const std::uint8_t seq = 0) {
+  const frame f = { frame::kind::registers, addr, seq, time,
+    { config.u16, masken.u16, alimit.u16 } };
+  return f.write(buf, size);
+}
+
+} // namespace encode
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+
+#include "ina260.hpp"
+
+// Composable fixed-point filter and decimation stages, applied in software to
+// the raw measurements acquired from the sensor.
+//
+// Hardware averaging (config::adc_count) is limited to 1024 samples and only
+// updates the measurement registers once every averaging period. Instead, the
+// sensor can convert at a fast rate, and a chain of these stages can produce
+// several slower output rates (e.g., 1 kHz → 100 Hz → 1 Hz) from the same
+// stream of samples.
+//
+// Every stage operates on raw register values (LSB) as std::int32_t, and
+// implements the following interface:
+//
+//   // Consume one input sample, and return true if an output sample was
+//   // produced (for decimating stages, once every Factor inputs, after any
+//   // warm-up period of the stage).
+//   bool push(const std::int32_t in, std::int32_t &out);
+//
+// Stages are selected at compile time as template arguments of filter::chain,
+// so the compiler can inline the entire pipeline.
+namespace filter {
+
+namespace detail {
+
+// Divide by a positive constant, rounding half away from zero.
+template <std::int64_t D>
+constexpr std::int64_t round_div(const std::int64_t n) {
+  return (n >= 0 ? n + D / 2 : n - D / 2) / D;
+}
+
+template <std::int64_t B, unsigned E>
+constexpr std::int64_t pow() {
+  if constexpr (E == 0) { return 1; } else { return B * pow<B, E - 1>(); }
+}
+
+} // namespace detail
+
+// Boxcar (moving sum) decimator: outputs the mean of each consecutive block of
+// Factor inputs.
+template <std::size_t Factor>
+class boxcar {
+public:
+  static_assert(Factor > 0, "decimation factor must be positive");
+
+  static constexpr std::size_t factor = Factor;
+
+  bool push(const std::int32_t in, std::int32_t &out) {
+    _sum += in;
+    if (++_n < Factor) {
+      return false;
+    }
+    out = static_cast<std::int32_t>(
+      detail::round_div<static_cast<std::int64_t>(Factor)>(_sum));
+    _sum = 0;
+    _n = 0;
+    return true;
+  }
+
+private:
+  std::int64_t _sum = 0;
+  std::size_t  _n   = 0;
+};
+
+// Cascaded integrator-comb (CIC) decimator of the given Order, with decimation
+// Factor and unit differential delay. Output is normalized by the DC gain of
+// Factor^Order. Compared to a single boxcar, higher orders give much greater
+// attenuation of aliased frequencies at the same (multiply-free) cost.
+//
+// The combs start from zero, so the first Order - 1 decimated outputs would only
+// be startup transients (e.g., 220 and 880 for a constant 1000 into cic<10, 3>).
+// They are suppressed: the first output is produced after Order * Factor inputs,
+// and once every Factor inputs thereafter.
+template <std::size_t Factor, unsigned Order = 3>
+class cic {
+public:
+  static_assert(Factor > 0 && Order > 0, "invalid CIC parameters");
+
+  static constexpr std::size_t factor = Factor;
+  static constexpr std::int64_t gain =
+    detail::pow<static_cast<std::int64_t>(Factor), Order>();
+
+  static_assert(gain < (std::int64_t{1} << 46),
+    "CIC gain would overflow 64-bit registers with 16-bit inputs");
+
+  bool push(const std::int32_t in, std::int32_t &out) {
+    // Integrators and combs rely on wrapping (modular) arithmetic, which is
+    // well-defined for unsigned types.
+    std::uint64_t acc = static_cast<std::uint64_t>(static_cast<std::int64_t>(in));
+    for (auto &i : _integ) {
+      i += acc;
+      acc = i;
+    }
+    if (++_n < Factor) {
+      return false;
+    }
+    _n = 0;
+    for (auto &c : _comb) {
+      const std::uint64_t prev = c;
+      c = acc;
+      acc -= prev;
+    }
+    if (_warm < Order - 1) {
+      ++_warm;
+      return false;
+    }
+    out = static_cast<std::int32_t>(
+      detail::round_div<gain>(static_cast<std::int64_t>(acc)));
+    return true;
+  }
+
+private:
+  std::array<std::uint64_t, Order> _integ = {};
+  std::array<std::uint64_t, Order> _comb  = {};
+  std::size_t                      _n     = 0;
+  unsigned                         _warm  = 0; // decimated outputs suppressed
+};
+
+// Single-pole IIR low-pass (exponential moving average):
+//
+//   y += (x - y) / 2^Shift
+//
+// The state retains Frac additional fractional bits so that small input
+// changes are not lost to truncation. Does not decimate.
+template <unsigned Shift, unsigned Frac = 8>
+class iir {
+public:
+  static_assert(Shift > 0 && Shift + Frac < 32, "invalid IIR parameters");
+
+  static constexpr std::size_t factor = 1;
+
+  bool push(const std::int32_t in, std::int32_t &out) {
+    const std::int64_t x = static_cast<std::int64_t>(in) * (std::int64_t{1} << Frac);
+    if (!_init) {
+      _y = x;
+      _init = true;
+    } else {
+      _y += (x - _y) / (std::int64_t{1} << Shift);
+    }
+    out = static_cast<std::int32_t>(
+      detail::round_div<(std::int64_t{1} << Frac)>(_y));
+    return true;
+  }
+
+private:
+  std::int64_t _y    = 0;
+  bool         _init = false;
+};
+
+// Median of the most recent N inputs, for rejecting isolated spikes (an impulse
+// shorter than N / 2 samples is removed entirely). Does not decimate; until N
+// inputs have been received, outputs the median of those available.
+template <std::size_t N>
+class median {
+public:
+  static_assert(N % 2 == 1, "median window must be odd");
+
+  static constexpr std::size_t factor = 1;
+
+  bool push(const std::int32_t in, std::int32_t &out) {
+    // Remove the oldest value from the sorted window, then insert the newest.
+    std::size_t k = _size;
+    if (_size == N) {
+      const std::int32_t old = _ring[_head];
+      std::size_t i = 0;
+      while (_sorted[i] != old) { ++i; }
+      for (; i + 1 < N; ++i) { _sorted[i] = _sorted[i + 1]; }
+      k = N - 1;
+    } else {
+      ++_size;
+    }
+    for (; k > 0 && _sorted[k - 1] > in; --k) {
+      _sorted[k] = _sorted[k - 1];
+    }
+    _sorted[k] = in;
+    _ring[_head] = in;
+    _head = (_head + 1 == N) ? 0 : _head + 1;
+    out = _sorted[(_size - 1) / 2];
+    return true;
+  }
+
+private:
+  std::array<std::int32_t, N> _ring   = {};
+  std::array<std::int32_t, N> _sorted = {};
+  std::size_t                 _head   = 0;
+  std::size_t                 _size   = 0;
+};
+
+// Pipeline of filter stages, each consuming the outputs of the previous stage.
+//
+// The most recent output of each stage remains available via output<I>(), so a
+// single chain provides every intermediate rate. For example, with raw samples
+// at 1 kHz:
+//
+//   filter::chain<filter::median<3>, filter::boxcar<10>, filter::cic<100>> f;
+//   switch (f.push(x)) {
+//     case 3: // f.output<2>() is a new 1 Hz sample
+//     case 2: // f.output<1>() is a new 100 Hz sample
+//     case 1: // f.output<0>() is a new 1 kHz (despiked) sample
+//   }
+template <typename ...Stage>
+class chain {
+public:
+  static_assert(sizeof...(Stage) > 0, "filter chain must have a stage");
+
+  static constexpr std::size_t depth = sizeof...(Stage);
+
+  // Return the total decimation factor from the input to stage I's output.
+  template <std::size_t I = depth - 1>
+  static constexpr std::size_t factor() {
+    if constexpr (I == 0) {
+      return std::tuple_element_t<0, std::tuple<Stage...>>::factor;
+    } else {
+      return std::tuple_element_t<I, std::tuple<Stage...>>::factor * factor<I - 1>();
+    }
+  }
+
+  // Feed one input sample through the chain, and return the number of stages
+  // that produced a new output (0 – depth). A stage that is still warming up
+  // (see cic) produces no output, so the stages following it produce their
+  // first outputs later than their decimation factors alone would suggest.
+  std::size_t push(const std::int32_t in) {
+    return push_from<0>(in);
+  }
+
+  // Return the most recent output of stage I.
+  template <std::size_t I = depth - 1>
+  std::int32_t output() const { return _out[I]; }
+
+private:
+  std::tuple<Stage...>             _stage;
+  std::array<std::int32_t, depth>  _out = {};
+
+  template <std::size_t I>
+  std::size_t push_from(const std::int32_t in) {
+    if (!std::get<I>(_stage).push(in, _out[I])) {
+      return I;
+    }
+    if constexpr (I + 1 < depth) {
+      return push_from<I + 1>(_out[I]);
+    } else {
+      return depth;
+    }
+  }
+};
+
+// Independent instances of a filter chain for each measurement channel of the
+// INA260. All channels decimate in lockstep, so a single depth is returned.
+template <typename Chain>
+struct channels {
+  Chain voltage;
+  Chain current;
+  Chain power;
+
+  std::size_t push(const ina260::sample &sample) {
+    (void)voltage.push(sample.value(ina260::config::op_type::voltage));
+    (void)current.push(sample.value(ina260::config::op_type::current));
+    return power.push(sample.value(ina260::config::op_type::power));
+  }
+};
+
+} // namespace filter
@@ -42,4 +42,31 @@ struct I2C {
   virtual std::size_t read(const std::uint8_t addr, std::uint8_t * const &data, const std::size_t size) = 0;
 };
 
+// Pure abstract class that extends I2C with non-blocking operations.
+//
+// Each operation only submits the transaction and returns immediately. Once the
+// transaction completes, the given callback is invoked exactly once with the
+// given context and the number of bytes transferred (0 on failure). Callbacks
+// may be invoked from any thread, including before the submitting call returns,
+// so they must not block.
+//
+// Byte order is handled exactly as in the synchronous operations. Data to be
+// written is consumed before the submitting call returns, but the buffer of a
+// read must remain valid until its callback is invoked.
+struct AsyncI2C: public I2C {
+  using callback = void (*)(void *context, const std::size_t count);
+
+  // Submit a write of data with the given number of bytes to the specified
+  // memory address. Returns false, without invoking the callback, if the
+  // operation could not be submitted.
+  virtual bool write_async(const std::uint8_t addr, const std::uint8_t * const &data, const std::size_t size,
+    callback done, void *context) = 0;
+
+  // Submit a read of the given number of bytes from the specified memory
+  // address. Returns false, without invoking the callback, if the operation
+  // could not be submitted.
+  virtual bool read_async(const std::uint8_t addr, std::uint8_t * const &data, const std::size_t size,
+    callback done, void *context) = 0;
+};
+
 } // namespace proto
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#include "pvc/i2c.hpp"
+
+// Named for the Linux i2c-dev interface, since "linux" is a predefined macro
+// with GNU extensions.
+namespace i2cdev {
+
+// A Linux I²C bus (/dev/i2c-N), shared by any number of devices.
+//
+// All transactions on the bus are performed in order by a dedicated I/O thread,
+// which sleeps on an eventfd until transactions are submitted. The bus
+// frequency is configured by the kernel (e.g., device tree), not by software.
+class bus {
+public:
+  // Largest number of data bytes of a single transaction.
+  static constexpr std::size_t max_size = 8;
+
+  // Open the given bus device, and start its I/O thread.
+  explicit bus(const char *path)
+    : _fd(::open(path, O_RDWR | O_CLOEXEC)), _event(::eventfd(0, EFD_CLOEXEC)) {
+    if (ok()) {
+      _thread = std::thread([this] { loop(); });
+    }
+  }
+
+  virtual ~bus() {
+    if (_thread.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _run = false;
+      }
+      signal();
+      _thread.join();
+    }
+    if (_event >= 0) { ::close(_event); }
+    if (_fd >= 0) { ::close(_fd); }
+  }
+
+  bus(const bus &) = delete;
+  bus &operator=(const bus &) = delete;
+
+  // Verify the bus device was opened.
+  bool ok() const { return _fd >= 0 && _event >= 0; }
+
+  // Submit a transaction with the device at the given address. Data to be
+  // written is copied before returning. Returns false if the bus is not open,
+  // or the size exceeds max_size.
+  bool submit(const std::uint16_t dev, const std::uint8_t addr, const bool write,
+    std::uint8_t *data, const std::size_t size,
+    proto::AsyncI2C::callback done, void *context) {
+    if (!ok() || size > max_size) {
+      return false;
+    }
+    request r = { dev, addr, write, data, size, done, context, {} };
+    if (write) {
+      std::reverse_copy(data, data + size, r.out);
+    }
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _queue.push_back(r);
+    }
+    signal();
+    return true;
+  }
+
+protected:
+  struct request {
+    std::uint16_t             dev;
+    std::uint8_t              addr;
+    bool                      write;
+    std::uint8_t             *data;
+    std::size_t               size;
+    proto::AsyncI2C::callback done;
+    void                     *context;
+    std::uint8_t              out[max_size]; // written data, device byte order
+  };
+
+  int                  _fd;
+  int                  _event;
+  std::thread          _thread;
+  std::mutex           _mutex;
+  std::vector<request> _queue;
+  bool                 _run = true;
+
+  void signal() {
+    const std::uint64_t one = 1;
+    (void)!::write(_event, &one, sizeof(one));
+  }
+
+  void loop() {
+    std::vector<request> batch;
+    for (;;) {
+      std::uint64_t count = 0;
+      (void)!::read(_event, &count, sizeof(count)); // blocks until signaled
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_run) {
+          break;
+        }
+        batch.swap(_queue);
+      }
+      for (auto &r : batch) {
+        r.done(r.context, execute(r));
+      }
+      batch.clear();
+    }
+    // Fail any transaction submitted after the bus was stopped.
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto &r : _queue) {
+      r.done(r.context, 0);
+    }
+    _queue.clear();
+  }
+
+  // Perform a transaction, and return the number of data bytes transferred.
+  std::size_t execute(request &r) {
+    std::uint8_t buf[max_size + 1] = { r.addr };
+    i2c_msg msg[2] = {};
+    i2c_rdwr_ioctl_data xfer = { msg, 0 };
+    if (r.write) {
+      std::memcpy(buf + 1, r.out, r.size);
+      msg[0] = { r.dev, 0, static_cast<std::uint16_t>(r.size + 1), buf };
+      xfer.nmsgs = 1;
+    } else {
+      // Pointer write followed by a repeated START and the read.
+      msg[0] = { r.dev, 0, 1, &r.addr };
+      msg[1] = { r.dev, I2C_M_RD, static_cast<std::uint16_t>(r.size), buf };
+      xfer.nmsgs = 2;
+    }
+    if (::ioctl(_fd, I2C_RDWR, &xfer) < 0) {
+      return 0;
+    }
+    if (!r.write) {
+      std::reverse_copy(buf, buf + r.size, r.data);
+    }
+    return r.size;
+  }
+};
+
+// I²C controller adapter for a device on a Linux I²C bus.
+//
+// The synchronous operations are thin wrappers that submit an asynchronous
+// operation and wait for its completion, so they must not be called from a
+// completion callback.
+class I2C: public proto::AsyncI2C {
+public:
+  // Construct an adapter for a device on the given bus.
+  I2C(bus &bus) : _bus(bus), _addr(0) {}
+
+  virtual ~I2C() = default;
+
+  // (Re)Initialize the I²C controller interface.
+  // The I²C hardware and I/O pins must already be inititalized.
+  //
+  // The given device address will be used for all subsequent read/write
+  // operations. The bus frequency is configured by the kernel and is ignored.
+  bool init(const std::uint8_t addr, const std::uint32_t freq) override {
+    (void)freq;
+    _addr = addr;
+    return _bus.ok();
+  }
+
+  // Write data with the given number of bytes to the specified memory address,
+  // and return the number of bytes successfully written.
+  std::size_t write(const std::uint8_t addr, const std::uint8_t * const &data, const std::size_t size) override {
+    waiter w;
+    if (!write_async(addr, data, size, &waiter::done, &w)) {
+      return 0;
+    }
+    return w.wait();
+  }
+
+  // Read the given number of bytes from the specified memory address, and
+  // return the number of bytes successfully read.
+  std::size_t read(const std::uint8_t addr, std::uint8_t * const &data, const std::size_t size) override {
+    waiter w;
+    if (!read_async(addr, data, size, &waiter::done, &w)) {
+      return 0;
+    }
+    return w.wait();
+  }
+
+  bool write_async(const std::uint8_t addr, const std::uint8_t * const &data, const std::size_t size,
+    callback done, void *context) override {
+    return _bus.submit(_addr, addr, true,
+      const_cast<std::uint8_t *>(data), size, done, context);
+  }
+
+  bool read_async(const std::uint8_t addr, std::uint8_t * const &data, const std::size_t size,
+    callback done, void *context) override {
+    return _bus.submit(_addr, addr, false, data, size, done, context);
+  }
+
+protected:
+  bus          &_bus;
+  std::uint8_t  _addr;
+
+  // Completion of a synchronous operation.
+  struct waiter {
+    std::mutex              mutex;
+    std::condition_variable cond;
+    bool                    ready = false;
+    std::size_t             count = 0;
+
+    static void done(void *context, const std::size_t count) {
+      auto *w = static_cast<waiter *>(context);
+      std::lock_guard<std::mutex> lock(w->mutex);
+      w->count = count;
+      w->ready = true;
+      w->cond.notify_one();
+    }
+
+    std::size_t wait() {
+      std::unique_lock<std::mutex> lock(mutex);
+      cond.wait(lock, [this] { return ready; });
+      return count;
+    }
+  };
+};
+
+} // namespace i2cdev
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 
 namespace util {
 
@@ -10,4 +11,21 @@ using array = std::array<std::common_type_t<T...>, sizeof...(T)>;
 template <typename ...T>
 constexpr array<T...> make_array(T... args) { return { args... }; }
 
+// Return the number of bits required to represent the given value, i.e., the
+// one-based position of its most-significant set bit (0 if value is 0).
+constexpr unsigned bit_width(std::uint32_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return value ? 32U - static_cast<unsigned>(__builtin_clz(value)) : 0U;
+#else
+  unsigned width = 0;
+  for (; value != 0; value >>= 1) { ++width; }
+  return width;
+#endif
+}
+
+constexpr unsigned bit_width(std::uint64_t value) {
+  const auto hi = static_cast<std::uint32_t>(value >> 32);
+  return hi ? 32U + bit_width(hi) : bit_width(static_cast<std::uint32_t>(value));
+}
+
 } // namespace util
@@ -0,0 +1,294 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "pvc/internal/util.hpp"
+
+// Constant-memory, mergeable summaries of long-running measurement
+// distributions, for estimating quantiles (p50, p99, p99.9, etc.) without
+// retaining the samples themselves.
+namespace sketch {
+
+// Log-linear (HDR-style) histogram of unsigned integer values.
+//
+// Values below 2^Precision are counted exactly. Larger values are grouped into
+// buckets of 2^Precision equal-width sub-buckets per power of two, so that the
+// relative error of any reported quantile is at most 2^-Precision (e.g., ~3.1%
+// for the default Precision = 5).
+//
+// The histogram is intended to be fed with raw register values (LSB) so that
+// inserting a sample is a single count-leading-zeros, shift, and increment,
+// with no floating-point arithmetic. Multiply a reported quantile by the
+// corresponding ina260::lsb_* constant to obtain physical units. The signed
+// CURRENT register should be inserted as its magnitude.
+//
+// Bits is the width of the largest value that can be inserted (larger values
+// saturate), and Count is the type of each bucket's counter. The defaults cover
+// all 16-bit register values in 384 buckets (3 KiB). 64-bit counters never
+// overflow in practice, whereas a 32-bit counter of a steady rail sampled at
+// the fastest conversion rate (~3.5 kHz) overflows within about two weeks, or
+// sooner once merged. Counters saturate rather than wrap (see saturated()).
+template <unsigned Bits = 16, unsigned Precision = 5,
+  typename Count = std::uint64_t>
+class histogram {
+public:
+  static_assert(Bits <= 32 && Precision < Bits, "unsupported histogram shape");
+  static_assert(std::is_unsigned_v<Count>, "counters must be unsigned");
+
+  using count_type = Count;
+
+  static constexpr std::uint32_t max_value =
+    static_cast<std::uint32_t>((std::uint64_t{1} << Bits) - 1);
+  static constexpr std::size_t sub_count = std::size_t{1} << Precision;
+  static constexpr std::size_t bucket_count = (Bits - Precision + 1) * sub_count;
+
+  // Return the bucket that counts the given value.
+  static constexpr std::size_t index_of(const std::uint32_t value) {
+    const unsigned width = util::bit_width(value);
+    if (width <= Precision) {
+      return value;
+    }
+    const unsigned shift = width - Precision - 1;
+    return (static_cast<std::size_t>(shift + 1) << Precision) +
+      ((value >> shift) & (sub_count - 1));
+  }
+
+  // Return the smallest value counted by the given bucket.
+  static constexpr std::uint32_t lower_of(const std::size_t index) {
+    if (index < sub_count) {
+      return static_cast<std::uint32_t>(index);
+    }
+    const unsigned shift = static_cast<unsigned>(index >> Precision) - 1;
+    return static_cast<std::uint32_t>(
+      (sub_count + (index & (sub_count - 1))) << shift);
+  }
+
+  // Return the largest value counted by the given bucket.
+  static constexpr std::uint32_t upper_of(const std::size_t index) {
+    if (index < sub_count) {
+      return static_cast<std::uint32_t>(index);
+    }
+    const unsigned shift = static_cast<unsigned>(index >> Precision) - 1;
+    return lower_of(index) + ((std::uint32_t{1} << shift) - 1);
+  }
+
+  constexpr histogram() = default;
+
+  std::uint64_t count() const { return _count; }
+  std::uint32_t min() const { return _count ? _min : 0; }
+  std::uint32_t max() const { return _count ? _max : 0; }
+  const std::array<count_type, bucket_count> &buckets() const { return _bucket; }
+
+  // Return true if any bucket counter has saturated, in which case reported
+  // quantiles are no longer accurate.
+  bool saturated() const { return _saturated; }
+
+  void clear() { *this = histogram(); }
+
+  // Count n occurrences of the given value. Values beyond max_value saturate.
+  void insert(std::uint32_t value, const count_type n = 1) {
+    if (value > max_value) {
+      value = max_value;
+    }
+    add(_bucket[index_of(value)], n);
+    _count += n;
+    if (value < _min) { _min = value; }
+    if (value > _max) { _max = value; }
+  }
+
+  // Return the estimated value at the given quantile (0.0 – 1.0), which is the
+  // midpoint of the bucket containing that rank, clamped to the observed range.
+  std::uint32_t quantile(const double q) const {
+    if (_count == 0) {
+      return 0;
+    }
+    if (q <= 0.0) { return _min; }
+    if (q >= 1.0) { return _max; }
+    // Rank (one-based) of the requested quantile, rounded up.
+    auto rank = static_cast<std::uint64_t>(q * static_cast<double>(_count));
+    if (static_cast<double>(rank) < q * static_cast<double>(_count)) {
+      ++rank;
+    }
+    if (rank == 0) {
+      rank = 1;
+    }
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < bucket_count; ++i) {
+      seen += _bucket[i];
+      if (seen >= rank) {
+        const std::uint32_t lower = lower_of(i), upper = upper_of(i);
+        const std::uint32_t mid = lower + (upper - lower) / 2;
+        return mid < _min ? _min : (mid > _max ? _max : mid);
+      }
+    }
+    return _max;
+  }
+
+  // Add all counts of another histogram with identical shape into this one.
+  void merge(const histogram &other) {
+    if (other._count == 0) {
+      return;
+    }
+    for (std::size_t i = 0; i < bucket_count; ++i) {
+      add(_bucket[i], other._bucket[i]);
+    }
+    _count += other._count;
+    _saturated = _saturated || other._saturated;
+    if (other._min < _min) { _min = other._min; }
+    if (other._max > _max) { _max = other._max; }
+  }
+
+  // Serialized form (all integers are unsigned LEB128 varints unless noted):
+  //
+  //   magic      2 bytes  'P', 'Q'
+  //   version    1 byte   format version (1)
+  //   bits       1 byte   Bits
+  //   precision  1 byte   Precision
+  //   count, min, max
+  //   runs       number of non-empty buckets that follow
+  //   { index delta from previous non-empty bucket (first from 0), count }...
+  //
+  // Sparse histograms (typical for a single rail) encode in a few dozen bytes.
+  static constexpr std::uint8_t version = 1;
+
+  // Return the maximum number of bytes required to serialize any histogram.
+  static constexpr std::size_t max_serialized_size() {
+    return 5 + 10 * 3 + 5 + bucket_count * (5 + 10);
+  }
+
+  // Serialize this histogram into the given buffer, and return the number of
+  // bytes written, or 0 if the buffer is too small. The counts of a saturated
+  // histogram are inconsistent, so merge() rejects its serialized form.
+  std::size_t serialize(std::uint8_t *const buf, const std::size_t size) const {
+    std::size_t runs = 0;
+    for (const auto &n : _bucket) {
+      if (n) { ++runs; }
+    }
+    writer w{buf, size};
+    w.byte('P'); w.byte('Q');
+    w.byte(version);
+    w.byte(static_cast<std::uint8_t>(Bits));
+    w.byte(static_cast<std::uint8_t>(Precision));
+    w.varint(_count);
+    w.varint(min());
+    w.varint(max());
+    w.varint(runs);
+    std::size_t prev = 0;
+    for (std::size_t i = 0; i < bucket_count; ++i) {
+      if (_bucket[i]) {
+        w.varint(i - prev);
+        w.varint(_bucket[i]);
+        prev = i;
+      }
+    }
+    return w.ok ? w.pos : 0;
+  }
+
+  // Merge a serialized histogram into this one, and return the number of bytes
+  // consumed, or 0 if the buffer is malformed, has an incompatible shape, or
+  // would overflow any bucket counter of this histogram (in which case this
+  // histogram is unmodified).
+  std::size_t merge(const std::uint8_t *const buf, const std::size_t size) {
+    histogram other;
+    reader r{buf, size};
+    if (r.byte() != 'P' || r.byte() != 'Q' || r.byte() != version ||
+        r.byte() != Bits || r.byte() != Precision) {
+      return 0;
+    }
+    other._count = r.varint();
+    const std::uint64_t min = r.varint(), max = r.varint();
+    const std::uint64_t runs = r.varint();
+    std::uint64_t total = 0;
+    std::size_t index = 0;
+    for (std::uint64_t k = 0; r.ok && k < runs; ++k) {
+      // Buckets are serialized in strictly increasing order, so every delta
+      // after the first is positive.
+      const std::uint64_t delta = r.varint();
+      if ((k > 0 && delta == 0) || delta >= bucket_count - index) {
+        return 0;
+      }
+      index += static_cast<std::size_t>(delta);
+      const std::uint64_t n = r.varint();
+      if (n > std::numeric_limits<count_type>::max() - _bucket[index] ||
+          n > std::numeric_limits<std::uint64_t>::max() - total) {
+        return 0;
+      }
+      other._bucket[index] = static_cast<count_type>(n);
+      total += n;
+    }
+    if (!r.ok || total != other._count || min > max_value || max > max_value) {
+      return 0;
+    }
+    if (other._count) {
+      other._min = static_cast<std::uint32_t>(min);
+      other._max = static_cast<std::uint32_t>(max);
+    }
+    merge(other);
+    return r.pos;
+  }
+
+private:
+  std::array<count_type, bucket_count> _bucket = {};
+  std::uint64_t _count = 0;
+  std::uint32_t _min   = max_value;
+  std::uint32_t _max   = 0;
+  bool          _saturated = false;
+
+  // Add n to the given counter, saturating at its maximum.
+  void add(count_type &counter, const count_type n) {
+    if (n > std::numeric_limits<count_type>::max() - counter) {
+      counter = std::numeric_limits<count_type>::max();
+      _saturated = true;
+    } else {
+      counter = static_cast<count_type>(counter + n);
+    }
+  }
+
+  struct writer {
+    std::uint8_t *const buf;
+    const std::size_t   size;
+    std::size_t         pos = 0;
+    bool                ok  = true;
+
+    void byte(const std::uint8_t b) {
+      if (pos < size) { buf[pos++] = b; } else { ok = false; }
+    }
+    void varint(std::uint64_t v) {
+      for (; v >= 0x80; v >>= 7) {
+        byte(static_cast<std::uint8_t>(v | 0x80));
+      }
+      byte(static_cast<std::uint8_t>(v));
+    }
+  };
+
+  struct reader {
+    const std::uint8_t *const buf;
+    const std::size_t         size;
+    std::size_t               pos = 0;
+    bool                      ok  = true;
+
+    std::uint8_t byte() {
+      if (pos < size) { return buf[pos++]; }
+      ok = false;
+      return 0;
+    }
+    std::uint64_t varint() {
+      std::uint64_t v = 0;
+      for (unsigned shift = 0; ok && shift < 64; shift += 7) {
+        const std::uint8_t b = byte();
+        v |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+          return v;
+        }
+      }
+      ok = false;
+      return 0;
+    }
+  };
+};
+
+} // namespace sketch
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "ina260.hpp"
+
+// Warm-start initialization of many sensors.
+//
+// Rather than unconditionally reprogramming every device after each boot or
+// reconnect, warm_start() reads back the configuration registers of every
+// device and only rewrites those whose settings differ from the desired
+// register image. A device that retained its configuration (e.g., only the host
+// was restarted) costs four register reads and no writes.
+//
+// The devices are processed in three phases, each a single pass over all
+// devices without any delays, and the duration of each phase is reported:
+//  - probe:  initialize each adapter and verify the DEVICE_ID register;
+//  - verify: read the CONFIG, MASK/ENABLE, and ALERT_LIMIT registers;
+//  - update: write the registers that differ.
+//
+// Reading MASK/ENABLE clears a latched alert, as with pvc::read_masken().
+namespace startup {
+
+// Desired content of the configuration registers of a device.
+//
+// If config.reset() is set, the device is reset before writing the other
+// registers, but only if its settings differ from this image. The reset bit
+// itself is never compared.
+struct image {
+  ina260::config config = ina260::config();
+  ina260::masken masken = ina260::masken();
+  ina260::alimit alimit = ina260::alimit();
+
+  // Return true if the settings of every register are equal.
+  constexpr bool same_settings(const image &other) const {
+    return config.same_settings(other.config) &&
+      masken.same_settings(other.masken) &&
+      alimit.same_settings(other.alimit);
+  }
+};
+
+// Outcome of a warm start for a single device.
+struct status {
+  bool         present;    // device responded with the expected DEVICE_ID
+  bool         configured; // registers hold the desired settings
+  bool         reset;      // device was reset
+  std::uint8_t writes;     // registers written (including a reset)
+  image        actual;     // registers as read back, before any writes
+};
+
+// Outcome of a warm start for N devices.
+template <std::size_t N>
+struct report {
+  std::array<status, N> device;
+  std::uint32_t probe_us;  // duration of each phase
+  std::uint32_t verify_us;
+  std::uint32_t update_us;
+  std::uint32_t total_us;
+
+  std::size_t present() const { return count(&status::present); }
+  std::size_t configured() const { return count(&status::configured); }
+
+  std::size_t writes() const {
+    std::size_t n = 0;
+    for (const auto &d : device) {
+      n += d.writes;
+    }
+    return n;
+  }
+
+private:
+  std::size_t count(bool status::*flag) const {
+    std::size_t n = 0;
+    for (const auto &d : device) {
+      n += d.*flag ? 1 : 0;
+    }
+    return n;
+  }
+};
+
+namespace detail {
+
+template <typename Clock>
+std::uint32_t elapsed_us(const typename Clock::time_point &since) {
+  return static_cast<std::uint32_t>(
+    std::chrono::duration_cast<std::chrono::microseconds>(
+      Clock::now() - since).count());
+}
+
+} // namespace detail
+
+// Bring each of the given pvc drivers to its desired register image, writing
+// only the registers that differ, and fill in the given report. Each driver's
+// cached register content (pvc::config(), etc.) is updated to match the device.
+//
+// Devices that are absent or fail any transaction are left unconfigured and
+// may be retried by calling warm_start() again, which is inexpensive for
+// devices that are already configured. Returns true if every device is
+// configured. Timing uses the given Clock (e.g., a platform-specific clock).
+template <typename Clock = std::chrono::steady_clock, typename P, std::size_t N>
+bool warm_start(const std::array<P *, N> &sensors,
+  const std::array<image, N> &want, report<N> &r) {
+  r = {};
+  const auto t0 = Clock::now();
+
+  auto t = Clock::now();
+  for (std::size_t i = 0; i < N; ++i) {
+    r.device[i].present = sensors[i]->init() && sensors[i]->ready();
+  }
+  r.probe_us = detail::elapsed_us<Clock>(t);
+
+  t = Clock::now();
+  std::array<bool, N> verified = {};
+  for (std::size_t i = 0; i < N; ++i) {
+    auto &d = r.device[i];
+    verified[i] = d.present &&
+      sensors[i]->read_config(d.actual.config) &&
+      sensors[i]->read_masken(d.actual.masken) &&
+      sensors[i]->read_alimit(d.actual.alimit);
+  }
+  r.verify_us = detail::elapsed_us<Clock>(t);
+
+  t = Clock::now();
+  for (std::size_t i = 0; i < N; ++i) {
+    auto &d = r.device[i];
+    if (!verified[i]) {
+      continue;
+    }
+    P &sensor = *sensors[i];
+    image target = want[i];
+    (void)target.config.reset(false);
+    image current = d.actual;
+    bool ok = true;
+    if (want[i].config.reset() && !current.same_settings(target)) {
+      // A reset restores the power-on default of every register.
+      ok = sensor.write_config(want[i].config);
+      d.reset = ok;
+      ++d.writes;
+      current = image();
+    }
+    // If both the limit and the function change, disable the current function
+    // before writing the limit, and select the new one after, so that neither
+    // function ever compares against the other's limit.
+    const bool relimit = !current.alimit.same_settings(target.alimit);
+    if (ok && relimit && ((current.masken.u16 ^ target.masken.u16) &
+        ina260::masken::function_mask) != 0 &&
+        (current.masken.u16 & ina260::masken::function_mask) != 0) {
+      ina260::masken idle = current.masken;
+      idle.u16 &= static_cast<std::uint16_t>(~ina260::masken::function_mask);
+      ok = sensor.write_masken(idle);
+      ++d.writes;
+      current.masken = idle;
+    }
+    if (ok && relimit) {
+      ok = sensor.write_alimit(target.alimit);
+      ++d.writes;
+    }
+    if (ok && !current.masken.same_settings(target.masken)) {
+      ok = sensor.write_masken(target.masken);
+      ++d.writes;
+    }
+    if (ok && !current.config.same_settings(target.config)) {
+      ok = sensor.write_config(target.config);
+      ++d.writes;
+    }
+    if (ok) {
+      sensor.config() = target.config;
+      sensor.masken() = target.masken;
+      sensor.alimit() = target.alimit;
+    }
+    d.configured = ok;
+  }
+  r.update_us = detail::elapsed_us<Clock>(t);
+  r.total_us = detail::elapsed_us<Clock>(t0);
+
+  return r.configured() == N;
+}
+
+// Bring every given pvc driver to the same desired register image.
+template <typename Clock = std::chrono::steady_clock, typename P, std::size_t N>
+bool warm_start(const std::array<P *, N> &sensors,
+  const image &want, report<N> &r) {
+  std::array<image, N> all;
+  all.fill(want);
+  return warm_start<Clock>(sensors, all, r);
+}
+
+} // namespace startup
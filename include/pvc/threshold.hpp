@@ -0,0 +1,311 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "ina260.hpp"
+
+// Monitoring of multiple thresholds per rail using the single ALERT function
+// of the INA260.
+//
+// The device can only compare one measurement against one limit at a time, so
+// the monitor keeps all thresholds in software and programs the ALERT_LIMIT
+// register and MASK/ENABLE function bits with whichever pending boundary is
+// nearest to the most recent measurement. When the ALERT pin asserts, call
+// monitor::service() to update the threshold states and re-arm the device for
+// the next boundary. The host only communicates with the device when a
+// boundary is crossed, instead of polling the measurement registers.
+//
+// Only one boundary can be armed at a time, so the monitor chooses which one
+// according to its arming policy. With the default policy (escalation), it
+// arms the nearest boundary at which a threshold becomes active, so that an
+// escalation from a warning to a critical threshold is never missed. The
+// trade-offs of this policy are:
+//  - a threshold that becomes inactive again (its release) is only reported
+//    at the next alert, or the next service() or arm() call; and
+//  - if activations are pending on both sides of the measurement (e.g., under-
+//    and over-voltage), only the nearer one is armed until the next call.
+// The nearest policy instead arms whichever boundary is nearest, reporting
+// releases promptly but leaving further activations unmonitored meanwhile.
+namespace threshold {
+
+// Which side of the level activates a threshold.
+enum class direction : std::uint8_t {
+  over  = 0x00, // active when measurement >= level
+  under = 0x01, // active when measurement <= level
+};
+
+// A software threshold with hysteresis.
+//
+// Levels are expressed in raw register units (LSB) of the monitored channel.
+// An over threshold becomes active when the measurement reaches level, and
+// inactive again only once it falls below level - hysteresis. Likewise, an
+// under threshold becomes active at level and inactive above level +
+// hysteresis. Activation and release never overlap, so a constant measurement
+// never toggles the state, even without hysteresis.
+struct boundary {
+  std::uint16_t id;
+  direction     dir;
+  std::int32_t  level;
+  std::int32_t  hysteresis;
+  bool          active;
+
+  // Return the measurement at which this threshold next changes state.
+  constexpr std::int32_t pending() const {
+    if (dir == direction::over) {
+      return active ? level - hysteresis - 1 : level;
+    }
+    return active ? level + hysteresis + 1 : level;
+  }
+
+  // Return true if the pending state change is reached by increasing values.
+  constexpr bool rising() const {
+    return (dir == direction::over) != active;
+  }
+
+  // Update the state for the given measurement, and return true if it changed.
+  constexpr bool update(const std::int32_t value) {
+    const bool cross = rising() ? value >= pending() : value <= pending();
+    if (cross) {
+      active = !active;
+    }
+    return cross;
+  }
+};
+
+// Which pending boundary is armed when there are several (see program()).
+enum class arming : std::uint8_t {
+  escalation = 0x00, // nearest activation; nearest release only if none pending
+  nearest    = 0x01, // nearest boundary, whether activation or release
+};
+
+// Fixed-capacity set of at most N thresholds on a single channel, sorted by
+// level.
+template <std::size_t N>
+class monitor {
+public:
+  using boundary_type = threshold::boundary;
+
+  constexpr monitor(
+    const ina260::config::op_type channel = ina260::config::op_type::current,
+    const arming policy = arming::escalation)
+    : _channel(channel), _policy(policy) {}
+
+  ina260::config::op_type channel() const { return _channel; }
+  arming policy() const { return _policy; }
+  std::size_t size() const { return _size; }
+  const boundary_type *begin() const { return _set.data(); }
+  const boundary_type *end() const { return _set.data() + _size; }
+
+  // Add a threshold, keeping the set sorted by level.
+  // Returns false if the set is full or the id is already present.
+  bool insert(const std::uint16_t id, const direction dir,
+    const std::int32_t level, const std::int32_t hysteresis = 0) {
+    if (_size >= N || find(id) != nullptr) {
+      return false;
+    }
+    std::size_t i = _size;
+    for (; i > 0 && _set[i - 1].level > level; --i) {
+      _set[i] = _set[i - 1];
+    }
+    _set[i] = { id, dir, level, hysteresis < 0 ? -hysteresis : hysteresis, false };
+    ++_size;
+    return true;
+  }
+
+  // Remove the threshold with the given id.
+  bool erase(const std::uint16_t id) {
+    for (std::size_t i = 0; i < _size; ++i) {
+      if (_set[i].id == id) {
+        for (--_size; i < _size; ++i) {
+          _set[i] = _set[i + 1];
+        }
+        return true;
+      }
+    }
+    return false;
+  }
+
+  const boundary_type *find(const std::uint16_t id) const {
+    for (std::size_t i = 0; i < _size; ++i) {
+      if (_set[i].id == id) {
+        return &_set[i];
+      }
+    }
+    return nullptr;
+  }
+
+  // Update all thresholds for the given measurement, calling the given function
+  // with each threshold (as const boundary_type &) that changed state, in order
+  // of ascending level. Returns the number of thresholds that changed state.
+  template <typename F>
+  std::size_t update(const std::int32_t value, F &&changed) {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < _size; ++i) {
+      if (_set[i].update(value)) {
+        changed(static_cast<const boundary_type &>(_set[i]));
+        ++count;
+      }
+    }
+    return count;
+  }
+
+  // Compute the MASK/ENABLE and ALERT_LIMIT registers that arm the device for
+  // the pending boundary selected by the arming policy: the nearest pending
+  // activation (escalation), or the nearest of any pending boundary (nearest).
+  //
+  // Only the alert function bits of masken are modified; all other bits (latch
+  // enable, polarity, etc.) are preserved. Returns false if there is no
+  // boundary that can be armed, in which case all alert functions are disabled.
+  // The power channel only supports an over-limit function, so boundaries that
+  // are reached by falling power are never armed.
+  bool program(const std::int32_t value,
+    ina260::masken &masken, ina260::alimit &alimit) const {
+    constexpr auto none = std::numeric_limits<std::int32_t>::max();
+    // Distance to the nearest boundary in each direction, indexed by kind
+    // (0: activation, 1: release).
+    std::int32_t up[2] = { none, none }, down[2] = { none, none };
+    std::int32_t up_at[2] = {}, down_at[2] = {};
+    for (std::size_t i = 0; i < _size; ++i) {
+      const std::int32_t at = _set[i].pending();
+      const std::size_t kind = _set[i].active ? 1 : 0;
+      if (_set[i].rising()) {
+        if (at - value < up[kind]) { up[kind] = at - value; up_at[kind] = at; }
+      } else if (_channel != ina260::config::op_type::power) {
+        if (value - at < down[kind]) { down[kind] = value - at; down_at[kind] = at; }
+      }
+    }
+    std::size_t kind = 0;
+    if (_policy == arming::nearest || (up[0] == none && down[0] == none)) {
+      // Consider both kinds: choose the nearest in each direction.
+      kind = 1;
+      if (up[0] <= up[1]) { up[1] = up[0]; up_at[1] = up_at[0]; }
+      if (down[0] <= down[1]) { down[1] = down[0]; down_at[1] = down_at[0]; }
+    }
+    return arm_nearest(up[kind], up_at[kind], down[kind], down_at[kind],
+      masken, alimit);
+  }
+
+  // Read the monitored channel, update all thresholds (see update()), and arm
+  // the device for the boundary selected by the arming policy (see program()).
+  //
+  // The MASK/ENABLE and ALERT_LIMIT registers are only written if they differ
+  // from the values most recently written to the given pvc driver.
+  // Returns false if any I²C transaction failed.
+  template <typename P, typename F>
+  bool arm(P &sensor, F &&changed) {
+    std::int32_t value = 0;
+    if (!sensor.measure(_channel, value)) {
+      return false;
+    }
+    update(value, changed);
+    ina260::masken masken = sensor.masken();
+    ina260::alimit alimit = sensor.alimit();
+    (void)program(value, masken, alimit);
+    // The device compares the ALERT_LIMIT register using whichever function is
+    // selected at the time. If both change, disable the previous function
+    // before writing the new limit, and only then select the new function, so
+    // that neither function ever compares against the other's limit.
+    const bool relimit = alimit != sensor.alimit();
+    if (relimit && ((masken.u16 ^ sensor.masken().u16) &
+        ina260::masken::function_mask) != 0) {
+      ina260::masken idle = sensor.masken();
+      clear_functions(idle);
+      if (idle != sensor.masken() && !sensor.write_masken(idle)) {
+        return false;
+      }
+    }
+    if (relimit && !sensor.write_alimit(alimit)) {
+      return false;
+    }
+    if (masken != sensor.masken() && !sensor.write_masken(masken)) {
+      return false;
+    }
+    return true;
+  }
+
+  // Handle an assertion of the ALERT pin and re-arm the device.
+  //
+  // Reading the MASK/ENABLE register clears the alert function flag when the
+  // device is configured for latched alerts (alert_latch_enable), so this must
+  // be called once for each alert.
+  template <typename P, typename F>
+  bool service(P &sensor, F &&changed) {
+    ina260::masken flags;
+    if (!sensor.read_masken(flags)) {
+      return false;
+    }
+    return arm(sensor, changed);
+  }
+
+private:
+  ina260::config::op_type      _channel;
+  arming                       _policy;
+  std::array<boundary_type, N> _set  = {};
+  std::size_t                  _size = 0;
+
+  // Encode a raw measurement as an ALERT_LIMIT register value, saturating to
+  // the range of the channel's measurement register.
+  std::uint16_t encode(std::int32_t value) const {
+    if (_channel == ina260::config::op_type::current) {
+      if (value < std::numeric_limits<std::int16_t>::min()) {
+        value = std::numeric_limits<std::int16_t>::min();
+      } else if (value > std::numeric_limits<std::int16_t>::max()) {
+        value = std::numeric_limits<std::int16_t>::max();
+      }
+      return static_cast<std::uint16_t>(static_cast<std::int16_t>(value));
+    }
+    if (value < 0) {
+      value = 0;
+    } else if (value > std::numeric_limits<std::uint16_t>::max()) {
+      value = std::numeric_limits<std::uint16_t>::max();
+    }
+    return static_cast<std::uint16_t>(value);
+  }
+
+  // Arm the nearer of the given rising (up) and falling (down) boundaries, at
+  // the given distances from the measurement.
+  bool arm_nearest(const std::int32_t up, const std::int32_t up_at,
+    const std::int32_t down, const std::int32_t down_at,
+    ina260::masken &masken, ina260::alimit &alimit) const {
+    constexpr auto none = std::numeric_limits<std::int32_t>::max();
+    clear_functions(masken);
+    if (up == none && down == none) {
+      return false;
+    }
+    // The device compares with strict inequality (exceeds / drops below), and
+    // each boundary is reached inclusively (see boundary::pending()).
+    if (up <= down) {
+      set_function(masken, true);
+      alimit.limit(encode(up_at - 1));
+    } else {
+      set_function(masken, false);
+      alimit.limit(encode(down_at + 1));
+    }
+    return true;
+  }
+
+  static void clear_functions(ina260::masken &masken) {
+    masken.u16 &= static_cast<std::uint16_t>(~ina260::masken::function_mask);
+  }
+
+  void set_function(ina260::masken &masken, const bool over) const {
+    switch (_channel) {
+      case ina260::config::op_type::current:
+        (void)(over ? masken.alert_over_current(true) : masken.alert_under_current(true));
+        break;
+      case ina260::config::op_type::voltage:
+        (void)(over ? masken.alert_over_voltage(true) : masken.alert_under_voltage(true));
+        break;
+      case ina260::config::op_type::power:
+        (void)masken.alert_over_power(true);
+        break;
+      default:
+        break;
+    }
+  }
+};
+
+} // namespace threshold